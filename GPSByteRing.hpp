@@ -0,0 +1,152 @@
+#ifndef GPS_BYTE_RING_HPP
+#define GPS_BYTE_RING_HPP
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "GPSNMEAAtomic.hpp"
+#include "GPSNMEA.hpp"
+
+//=================================================================
+// 受信バイト用のロックフリー単一書き手・単一読み手(SPSC)リングバッファ
+//  書き手: UART割り込みハンドラ、またはホストの受信スレッド (push)
+//  読み手: ループ側 (drain / peek / consume)
+//  N は2のべき。添字は GPSSequence で回すので、AVR では N <= 128
+//
+//  使い方 (割り込み側):
+//    ring.push(UDR0);
+//  使い方 (ループ側):
+//    ring.drain(gps);   // 連続領域ごとに GPSNMEA::encode(buf, len) へ渡す
+//=================================================================
+template <size_t N>
+class GPSByteRing {
+public:
+	static_assert(N >= 2 && (N & (N - 1)) == 0, "GPSByteRing size must be a power of two");
+	static_assert(N <= (static_cast<GPSSequence>(~static_cast<GPSSequence>(0)) >> 1) + 1,
+		"GPSByteRing size exceeds the range of GPSSequence");
+
+	GPSByteRing() {}
+
+	static size_t capacity() { return N; }
+
+	// --------------------
+	// 書き手側
+	// --------------------
+
+	// 1バイト追加。満杯なら捨てて overflowCount() を増やし false
+	bool push(uint8_t b) {
+		GPSSequence h = head.loadRelaxed();
+		GPSSequence used = static_cast<GPSSequence>(h - tail.loadAcquire());
+		if (used >= N) {
+			overflows.storeRelaxed(overflows.loadRelaxed() + 1);
+			return false;
+		}
+		buf[h & MASK] = static_cast<char>(b);
+		head.storeRelease(static_cast<GPSSequence>(h + 1));
+		noteUsed(static_cast<size_t>(used) + 1);
+		return true;
+	}
+
+	// まとめて追加。入りきらない分は捨てて overflowCount() に数える。追加できたバイト数を返す
+	size_t push(const char *p, size_t len) {
+		GPSSequence h = head.loadRelaxed();
+		size_t used = static_cast<GPSSequence>(h - tail.loadAcquire());
+		size_t n = len < N - used ? len : N - used;
+		size_t at = h & MASK;
+		size_t first = n < N - at ? n : N - at;
+		memcpy(buf + at, p, first);
+		memcpy(buf, p + first, n - first);
+		head.storeRelease(static_cast<GPSSequence>(h + n));
+		if (n < len)
+			overflows.storeRelaxed(overflows.loadRelaxed() + static_cast<uint32_t>(len - n));
+		noteUsed(used + n);
+		return n;
+	}
+
+	// --------------------
+	// 読み手側
+	// --------------------
+
+	// 読み出せるバイト数
+	size_t size() const {
+		return static_cast<GPSSequence>(head.loadAcquire() - tail.loadRelaxed());
+	}
+	bool empty() const { return size() == 0; }
+
+	// 読み出せる先頭の連続領域。折り返しがあれば後半は次の peek() で得る
+	size_t peek(const char *&p) const {
+		GPSSequence t = tail.loadRelaxed();
+		size_t used = static_cast<GPSSequence>(head.loadAcquire() - t);
+		size_t at = t & MASK;
+		p = buf + at;
+		return used < N - at ? used : N - at;
+	}
+
+	// peek() で読んだ n バイトを解放する
+	void consume(size_t n) {
+		tail.storeRelease(static_cast<GPSSequence>(tail.loadRelaxed() + n));
+	}
+
+	// 最大 len バイトを取り出す
+	size_t read(char *out, size_t len) {
+		size_t total = 0;
+		const char *p;
+		size_t n;
+		while (total < len && (n = peek(p)) != 0) {
+			if (n > len - total)
+				n = len - total;
+			memcpy(out + total, p, n);
+			consume(n);
+			total += n;
+		}
+		return total;
+	}
+
+	// 溜まっているバイトを全て GPSNMEA::encode(buf, len) へ渡す
+	//  チェックサムまで処理完了したセンテンス数を返す
+	size_t drain(GPSNMEA &gps) {
+		size_t sentences = 0;
+		const char *p;
+		size_t n;
+		// 折り返し位置で区切って渡す。処理中に書き足された分も続けて処理する
+		while ((n = peek(p)) != 0) {
+			sentences += gps.encode(p, n);
+			consume(n);
+		}
+		return sentences;
+	}
+
+	// --------------------
+	// 統計 (バッファサイズの見積もり用)
+	// --------------------
+
+	// これまでの最大使用量
+	size_t highWaterMark() const { return highWater.loadRelaxed(); }
+	// 満杯で捨てたバイト数
+	uint32_t overflowCount() const { return overflows.loadRelaxed(); }
+	// 統計を0に戻す (書き手が止まっている時に呼ぶ)
+	void resetStats() {
+		highWater.storeRelaxed(0);
+		overflows.storeRelaxed(0);
+	}
+
+private:
+	GPSByteRing(const GPSByteRing &);
+	GPSByteRing &operator=(const GPSByteRing &);
+
+	static const size_t MASK = N - 1;
+
+	void noteUsed(size_t used) {
+		if (used > highWater.loadRelaxed())
+			highWater.storeRelaxed(static_cast<GPSSequence>(used));
+	}
+
+	char buf[N];
+	GPSAtomic<GPSSequence> head;  // 書き手だけが進める
+	GPSAtomic<GPSSequence> tail;  // 読み手だけが進める
+	GPSAtomic<GPSSequence> highWater;
+	GPSAtomic<uint32_t> overflows;
+};
+
+#endif // GPS_BYTE_RING_HPP
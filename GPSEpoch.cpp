@@ -0,0 +1,124 @@
+#include "GPSEpoch.hpp"
+
+#include <string.h>
+
+namespace {
+
+uint16_t gpsClampU16(int32_t v) {
+	return v < 0 ? 0 : v > 0xFFFF ? 0xFFFF : static_cast<uint16_t>(v);
+}
+
+} // namespace
+
+//-----------------------------------
+GPSEpochAssembler::GPSEpochAssembler()
+: closingType(GPSNMEA::SentenceType_Other)
+{
+	reset();
+}
+
+void GPSEpochAssembler::reset() {
+	memset(&current, 0, sizeof(current));
+	open = false;
+	readyHead = 0;
+	readyCount = 0;
+	dropped = 0;
+}
+
+bool GPSEpochAssembler::add(const GPSNMEA &gps) {
+	uint16_t fieldMask = gps.committedFields();
+	if (fieldMask == 0)
+		return false;
+
+	// 同じスレッドから呼ぶので snapshot() は書き込みと重ならず1回で読める
+	GPSSnapshot s;
+	gps.snapshot(s);
+
+	// 時刻が変わったら前のエポックを閉じる
+	bool closed = false;
+	if (open && (fieldMask & GPSNMEA::Field_Time) &&
+		(current.fields & GPSNMEA::Field_Time) && s.time != current.time)
+		closed = close();
+
+	merge(gps, s, fieldMask);
+
+	if (closingType != GPSNMEA::SentenceType_Other && gps.sentenceType() == closingType)
+		closed |= close();
+
+	return closed;
+}
+
+bool GPSEpochAssembler::flush() {
+	return close();
+}
+
+bool GPSEpochAssembler::read(GPSFix &out) {
+	if (readyCount == 0)
+		return false;
+	out = ready[readyHead];
+	readyHead = (readyHead + 1) % QUEUE_SIZE;
+	--readyCount;
+	return true;
+}
+
+void GPSEpochAssembler::merge(const GPSNMEA &gps, const GPSSnapshot &s, uint16_t fieldMask) {
+	open = true;
+	current.sentences |= static_cast<uint16_t>(GPSNMEA::sentenceBit(gps.sentenceType()));
+	current.fields |= fieldMask;
+
+	if (fieldMask & GPSNMEA::Field_Time)
+		current.time = s.time;
+	if (fieldMask & GPSNMEA::Field_Date)
+		current.date = s.date;
+	if (fieldMask & GPSNMEA::Field_Location) {
+		current.latE7 = gpsDegreesE7(s.lat);
+		current.lngE7 = gpsDegreesE7(s.lng);
+	}
+	if (fieldMask & GPSNMEA::Field_Altitude)
+		current.altitude = s.altitude;
+	if (fieldMask & GPSNMEA::Field_Speed)
+		current.speed = s.speed;
+	if (fieldMask & GPSNMEA::Field_Course)
+		current.course = s.course;
+	if (fieldMask & GPSNMEA::Field_Hdop)
+		current.hdop = gpsClampU16(s.hdop);
+	if (fieldMask & GPSNMEA::Field_Satellites)
+		current.satellites = static_cast<uint8_t>(s.satellites < 0 ? 0 : s.satellites > 255 ? 255 : s.satellites);
+	if (fieldMask & GPSNMEA::Field_GSA) {
+		current.pdop = gpsClampU16(gps.gsa.pdop);
+		current.vdop = gpsClampU16(gps.gsa.vdop);
+		current.fixType = static_cast<uint8_t>(gps.gsa.fixType);
+		// GGA が無いエポックでは GSA の HDOP を使う
+		if (!(current.fields & GPSNMEA::Field_Hdop)) {
+			current.hdop = gpsClampU16(gps.gsa.hdop);
+			current.fields |= GPSNMEA::Field_Hdop;
+		}
+	}
+	if (fieldMask & GPSNMEA::Field_VTG) {
+		// RMC が無いエポックでは VTG の対地速度・進行方向を使う
+		if (!(current.fields & GPSNMEA::Field_Speed)) {
+			current.speed = gps.vtg.speedKnots;
+			current.fields |= GPSNMEA::Field_Speed;
+		}
+		if (!(current.fields & GPSNMEA::Field_Course)) {
+			current.course = gps.vtg.trueTrack;
+			current.fields |= GPSNMEA::Field_Course;
+		}
+	}
+}
+
+bool GPSEpochAssembler::close() {
+	if (!open)
+		return false;
+	if (readyCount == QUEUE_SIZE) {
+		// 最も古いものを捨てる
+		readyHead = (readyHead + 1) % QUEUE_SIZE;
+		--readyCount;
+		++dropped;
+	}
+	ready[(readyHead + readyCount) % QUEUE_SIZE] = current;
+	++readyCount;
+	memset(&current, 0, sizeof(current));
+	open = false;
+	return true;
+}
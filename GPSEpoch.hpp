@@ -0,0 +1,81 @@
+#ifndef GPS_EPOCH_HPP
+#define GPS_EPOCH_HPP
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "GPSNMEA.hpp"
+
+// 1エポック(同じUTC時刻に出力されたRMC/GGA/GSA/VTGなど)をまとめた測位結果
+//  fields に無い項目は0
+struct GPSFix {
+	uint32_t date;          // ddmmyy
+	uint32_t time;          // hhmmsscc
+	int32_t latE7;          // 度 x1e7 (南緯は負)
+	int32_t lngE7;          // 度 x1e7 (西経は負)
+	int32_t altitude;       // m x100
+	int32_t speed;          // ノット x100
+	int32_t course;         // 度 x100
+	uint16_t hdop;          // x100
+	uint16_t pdop;          // x100 (GSA)
+	uint16_t vdop;          // x100 (GSA)
+	uint8_t satellites;
+	uint8_t fixType;        // GSA 1=NoFix,2=2D,3=3D (無ければ0)
+	uint16_t fields;        // このエポックで受信した項目 (GPSNMEA::Field_xxx のビット和)
+	uint16_t sentences;     // このエポックに含まれたセンテンス (GPSNMEA::sentenceBit のビット和)
+
+	bool hasLocation() const { return (fields & GPSNMEA::Field_Location) != 0; }
+};
+
+//=================================================================
+// センテンスをUTC時刻でエポックにまとめ、閉じたエポックを GPSFix として渡す
+//  時刻を持つセンテンス(RMC, GGA)の時刻が変わるか、closeOn() で指定した
+//  センテンスを受け取った時点でエポックを閉じる。時刻を持たないセンテンス
+//  (GSA, VTG)は開いているエポックに入る
+//
+//  使い方:
+//    if (gps.encode(c) && epochs.add(gps))
+//        while (epochs.read(fix)) { ... }
+//=================================================================
+class GPSEpochAssembler {
+public:
+	GPSEpochAssembler();
+	void reset();
+
+	// エポックを閉じるセンテンスを指定する (受信機の出力順で最後に来るもの)
+	//  SentenceType_Other なら時刻の変化だけで閉じる (既定)
+	void closeOn(GPSNMEA::SentenceType type) { closingType = type; }
+
+	// チェックサムまで処理し終えた直後の GPSNMEA を渡す
+	//  エポックが閉じて read() で取り出せる GPSFix があれば true
+	bool add(const GPSNMEA &gps);
+
+	// 開いているエポックを閉じる (ログの末尾など)
+	bool flush();
+
+	// 閉じたエポックを古い順に1つ取り出す
+	bool read(GPSFix &out);
+	size_t available() const { return readyCount; }
+
+	// read() されないまま上書きされたエポック数
+	uint32_t droppedCount() const { return dropped; }
+
+private:
+	// 1回の add() で閉じるのは最大2つ (時刻の変化と closeOn)
+	static const int QUEUE_SIZE = 2;
+
+	void merge(const GPSNMEA &gps, const GPSSnapshot &s, uint16_t fieldMask);
+	// 開いていれば閉じてキューへ入れる。キューが一杯なら最も古いものを捨てる
+	bool close();
+
+	GPSFix current;
+	bool open;
+	GPSNMEA::SentenceType closingType;
+
+	GPSFix ready[QUEUE_SIZE];
+	uint8_t readyHead;
+	uint8_t readyCount;
+	uint32_t dropped;
+};
+
+#endif // GPS_EPOCH_HPP
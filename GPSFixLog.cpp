@@ -0,0 +1,299 @@
+#include "GPSFixLog.hpp"
+
+#include <string.h>
+
+namespace {
+
+const uint8_t kMagic[4] = { 'G', 'F', 'X', 1 };
+const size_t kHeaderSize = sizeof(kMagic);
+
+// 1レコードの最大長 (flags + 可変長整数13個 + 2バイト)
+const size_t kMaxRecord = 64;
+static_assert(GPSNMEA_FIXLOG_BLOCK_SIZE >= kMaxRecord, "GPSNMEA_FIXLOG_BLOCK_SIZE is too small");
+
+enum {
+	Flag_Keyframe  = 1 << 0,
+	Flag_Fields    = 1 << 1,
+	Flag_Sentences = 1 << 2,
+	Flag_Date      = 1 << 3
+};
+
+// --------------------
+// 可変長整数 (LEB128) と zigzag
+// --------------------
+inline uint8_t *putVarint(uint8_t *p, uint32_t v) {
+	while (v >= 0x80) {
+		*p++ = static_cast<uint8_t>(v | 0x80);
+		v >>= 7;
+	}
+	*p++ = static_cast<uint8_t>(v);
+	return p;
+}
+
+inline uint8_t *putDelta(uint8_t *p, int32_t cur, int32_t prev) {
+	// 差分は uint32 で取り、int32 の範囲を超えても可逆にする
+	uint32_t d = static_cast<uint32_t>(cur) - static_cast<uint32_t>(prev);
+	uint32_t z = (d << 1) ^ static_cast<uint32_t>(-static_cast<int32_t>(d >> 31));
+	return putVarint(p, z);
+}
+
+inline bool getVarint(const uint8_t *&p, const uint8_t *end, uint32_t &v) {
+	v = 0;
+	for (unsigned shift = 0; shift < 35; shift += 7) {
+		if (p >= end)
+			return false;
+		uint8_t b = *p++;
+		v |= static_cast<uint32_t>(b & 0x7F) << shift;
+		if (!(b & 0x80))
+			return true;
+	}
+	return false;
+}
+
+inline bool getDelta(const uint8_t *&p, const uint8_t *end, int32_t prev, int32_t &cur) {
+	uint32_t z;
+	if (!getVarint(p, end, z))
+		return false;
+	uint32_t d = (z >> 1) ^ (0u - (z & 1));
+	cur = static_cast<int32_t>(static_cast<uint32_t>(prev) + d);
+	return true;
+}
+
+// fields に含まれる項目を差分で書く (base はキーフレームなら0)
+uint8_t *encodeRecord(uint8_t *p, const GPSFix &fix, const GPSFix &base, bool keyframe) {
+	uint8_t *flags = p++;
+	uint8_t f = keyframe ? Flag_Keyframe : 0;
+	if (keyframe || fix.fields != base.fields) {
+		f |= Flag_Fields;
+		p = putVarint(p, fix.fields);
+	}
+	if (keyframe || fix.sentences != base.sentences) {
+		f |= Flag_Sentences;
+		p = putVarint(p, fix.sentences);
+	}
+	uint16_t fields = fix.fields;
+	if ((fields & GPSNMEA::Field_Date) && (keyframe || fix.date != base.date)) {
+		f |= Flag_Date;
+		p = putVarint(p, fix.date);
+	}
+	*flags = f;
+
+	if (fields & GPSNMEA::Field_Time)
+		p = putDelta(p, static_cast<int32_t>(fix.time), static_cast<int32_t>(base.time));
+	if (fields & GPSNMEA::Field_Location) {
+		p = putDelta(p, fix.latE7, base.latE7);
+		p = putDelta(p, fix.lngE7, base.lngE7);
+	}
+	if (fields & GPSNMEA::Field_Altitude)
+		p = putDelta(p, fix.altitude, base.altitude);
+	if (fields & GPSNMEA::Field_Speed)
+		p = putDelta(p, fix.speed, base.speed);
+	if (fields & GPSNMEA::Field_Course)
+		p = putDelta(p, fix.course, base.course);
+	if (fields & GPSNMEA::Field_Hdop)
+		p = putDelta(p, fix.hdop, base.hdop);
+	if (fields & GPSNMEA::Field_GSA) {
+		p = putDelta(p, fix.pdop, base.pdop);
+		p = putDelta(p, fix.vdop, base.vdop);
+		*p++ = fix.fixType;
+	}
+	if (fields & GPSNMEA::Field_Satellites)
+		*p++ = fix.satellites;
+	return p;
+}
+
+// 次のレコードの差分の基準を更新する。fields に無い項目は直前の値を引き継ぐ
+void updateBase(GPSFix &base, const GPSFix &fix) {
+	uint16_t fields = fix.fields;
+	base.fields = fix.fields;
+	base.sentences = fix.sentences;
+	if (fields & GPSNMEA::Field_Date)
+		base.date = fix.date;
+	if (fields & GPSNMEA::Field_Time)
+		base.time = fix.time;
+	if (fields & GPSNMEA::Field_Location) {
+		base.latE7 = fix.latE7;
+		base.lngE7 = fix.lngE7;
+	}
+	if (fields & GPSNMEA::Field_Altitude)
+		base.altitude = fix.altitude;
+	if (fields & GPSNMEA::Field_Speed)
+		base.speed = fix.speed;
+	if (fields & GPSNMEA::Field_Course)
+		base.course = fix.course;
+	if (fields & GPSNMEA::Field_Hdop)
+		base.hdop = fix.hdop;
+	if (fields & GPSNMEA::Field_GSA) {
+		base.pdop = fix.pdop;
+		base.vdop = fix.vdop;
+		base.fixType = fix.fixType;
+	}
+	if (fields & GPSNMEA::Field_Satellites)
+		base.satellites = fix.satellites;
+}
+
+} // namespace
+
+//-----------------------------------
+// GPSFixLogWriter
+//-----------------------------------
+GPSFixLogWriter::GPSFixLogWriter(OutputCallback output, void *context, uint16_t keyframeInterval)
+: output(output),
+	context(context),
+	keyframeInterval(keyframeInterval == 0 ? 1 : keyframeInterval),
+	sinceKeyframe(0),
+	records(0),
+	written(0),
+	lastOffset(0),
+	lastKeyframe(false),
+	headerWritten(false),
+	used(0)
+{
+	memset(&prev, 0, sizeof(prev));
+	forceKeyframe();
+}
+
+GPSFixLogWriter::~GPSFixLogWriter() {
+	flush();
+}
+
+bool GPSFixLogWriter::write(const GPSFix &fix) {
+	if (!headerWritten) {
+		memcpy(block, kMagic, kHeaderSize);
+		used = kHeaderSize;
+		headerWritten = true;
+	}
+	if (used + kMaxRecord > sizeof(block) && !flush())
+		return false;
+
+	bool keyframe = sinceKeyframe >= keyframeInterval;
+	if (keyframe) {
+		memset(&prev, 0, sizeof(prev));
+		sinceKeyframe = 0;
+	}
+	lastOffset = written + static_cast<uint32_t>(used);
+	lastKeyframe = keyframe;
+	uint8_t *end = encodeRecord(block + used, fix, prev, keyframe);
+	used = static_cast<size_t>(end - block);
+	updateBase(prev, fix);
+
+	++sinceKeyframe;
+	++records;
+	return true;
+}
+
+bool GPSFixLogWriter::flush() {
+	if (used == 0)
+		return true;
+	if (output != nullptr && !output(block, used, context))
+		return false;
+	written += static_cast<uint32_t>(used);
+	used = 0;
+	return true;
+}
+
+//-----------------------------------
+// GPSFixLogReader
+//-----------------------------------
+GPSFixLogReader::GPSFixLogReader(const uint8_t *data, size_t len)
+: data(data),
+	len(len),
+	pos(kHeaderSize),
+	headerValid(len >= kHeaderSize && memcmp(data, kMagic, kHeaderSize) == 0),
+	synced(false),
+	error(false)
+{
+	memset(&prev, 0, sizeof(prev));
+	if (!headerValid)
+		pos = len;
+}
+
+bool GPSFixLogReader::seek(size_t offset) {
+	if (!headerValid || offset < kHeaderSize || offset >= len || !(data[offset] & Flag_Keyframe))
+		return false;
+	pos = offset;
+	synced = false;
+	error = false;
+	return true;
+}
+
+bool GPSFixLogReader::next(GPSFix &fix) {
+	if (error || pos >= len)
+		return false;
+
+	const uint8_t *p = data + pos;
+	const uint8_t *end = data + len;
+	uint8_t f = *p++;
+	if (f & Flag_Keyframe) {
+		memset(&prev, 0, sizeof(prev));
+		synced = true;
+	} else if (!synced) {
+		// 差分の基準となるキーフレームを読んでいない
+		error = true;
+		return false;
+	}
+
+	GPSFix out;
+	memset(&out, 0, sizeof(out));
+	uint32_t v;
+	bool ok = true;
+	out.fields = prev.fields;
+	out.sentences = prev.sentences;
+	if (f & Flag_Fields) {
+		ok = ok && getVarint(p, end, v);
+		out.fields = static_cast<uint16_t>(v);
+	}
+	if (ok && (f & Flag_Sentences)) {
+		ok = getVarint(p, end, v);
+		out.sentences = static_cast<uint16_t>(v);
+	}
+	uint16_t fields = out.fields;
+	if (fields & GPSNMEA::Field_Date) {
+		out.date = prev.date;
+		if (ok && (f & Flag_Date)) {
+			ok = getVarint(p, end, v);
+			out.date = v;
+		}
+	}
+
+	int32_t d;
+	if (ok && (fields & GPSNMEA::Field_Time)) {
+		ok = getDelta(p, end, static_cast<int32_t>(prev.time), d);
+		out.time = static_cast<uint32_t>(d);
+	}
+	if (ok && (fields & GPSNMEA::Field_Location))
+		ok = getDelta(p, end, prev.latE7, out.latE7) && getDelta(p, end, prev.lngE7, out.lngE7);
+	if (ok && (fields & GPSNMEA::Field_Altitude))
+		ok = getDelta(p, end, prev.altitude, out.altitude);
+	if (ok && (fields & GPSNMEA::Field_Speed))
+		ok = getDelta(p, end, prev.speed, out.speed);
+	if (ok && (fields & GPSNMEA::Field_Course))
+		ok = getDelta(p, end, prev.course, out.course);
+	if (ok && (fields & GPSNMEA::Field_Hdop)) {
+		ok = getDelta(p, end, prev.hdop, d);
+		out.hdop = static_cast<uint16_t>(d);
+	}
+	if (ok && (fields & GPSNMEA::Field_GSA)) {
+		ok = getDelta(p, end, prev.pdop, d);
+		out.pdop = static_cast<uint16_t>(d);
+		ok = ok && getDelta(p, end, prev.vdop, d);
+		out.vdop = static_cast<uint16_t>(d);
+		ok = ok && p < end;
+		if (ok)
+			out.fixType = *p++;
+	}
+	if (ok && (fields & GPSNMEA::Field_Satellites)) {
+		ok = p < end;
+		if (ok)
+			out.satellites = *p++;
+	}
+
+	if (!ok) {
+		error = true;
+		return false;
+	}
+	pos = static_cast<size_t>(p - data);
+	updateBase(prev, out);
+	fix = out;
+	return true;
+}
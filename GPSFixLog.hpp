@@ -0,0 +1,99 @@
+#ifndef GPS_FIX_LOG_HPP
+#define GPS_FIX_LOG_HPP
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "GPSNMEAConfig.hpp"
+#include "GPSEpoch.hpp"
+
+//=================================================================
+// GPSFix のバイナリログ
+//
+//  ファイル先頭: "GFX" + 版数(1) の4バイト
+//  レコード: [flags] [fields] [sentences] [date] [time] [lat] [lng] [altitude]
+//            [speed] [course] [hdop] [pdop] [vdop] [fixType] [satellites]
+//    flags    bit0 キーフレーム (直前の値を0として差分を取る)
+//             bit1 fields あり / bit2 sentences あり (無ければ直前と同じ)
+//             bit3 date あり (無ければ直前と同じ)
+//    fields, sentences, date は符号なし可変長整数 (LEB128)
+//    以降は fields に含まれる項目だけが並び、直前のレコードとの差分を
+//    zigzag 化した可変長整数で持つ (fixType, satellites は1バイトそのまま)
+//
+//  キーフレームからは前のレコードを読まずにデコードを始められる
+//=================================================================
+
+// 書き手: レコードを内部バッファに溜め、一杯になるか flush() で出力コールバックへ渡す
+class GPSFixLogWriter {
+public:
+	// 出力先 (ファイル書き込みなど)。失敗なら false
+	typedef bool (*OutputCallback)(const uint8_t *data, size_t len, void *context);
+
+	GPSFixLogWriter(OutputCallback output, void *context = nullptr, uint16_t keyframeInterval = 256);
+	~GPSFixLogWriter();
+
+	// 1エポック分を追記する。出力に失敗したら false
+	bool write(const GPSFix &fix);
+	// 溜まっているレコードを出力する
+	bool flush();
+
+	// 次のレコードを強制的にキーフレームにする (ファイルを区切る時など)
+	void forceKeyframe() { sinceKeyframe = keyframeInterval; }
+
+	uint32_t recordCount() const { return records; }
+	// ヘッダを含む出力済み + バッファ中のバイト数
+	uint32_t bytesWritten() const { return written + static_cast<uint32_t>(used); }
+	// 直前に書いたレコードが始まる位置 (ファイル先頭から)
+	uint32_t lastRecordOffset() const { return lastOffset; }
+	bool lastRecordWasKeyframe() const { return lastKeyframe; }
+
+private:
+	GPSFixLogWriter(const GPSFixLogWriter &);
+	GPSFixLogWriter &operator=(const GPSFixLogWriter &);
+
+	OutputCallback output;
+	void *context;
+	uint16_t keyframeInterval;
+	uint16_t sinceKeyframe;
+
+	GPSFix prev;
+	uint32_t records;
+	uint32_t written;
+	uint32_t lastOffset;
+	bool lastKeyframe;
+	bool headerWritten;
+
+	size_t used;
+	uint8_t block[GPSNMEA_FIXLOG_BLOCK_SIZE];
+};
+
+// 読み手: メモリ上(mmapしたファイルなど)のログを順にデコードする。コピーや確保はしない
+class GPSFixLogReader {
+public:
+	GPSFixLogReader(const uint8_t *data, size_t len);
+
+	// 先頭のヘッダが正しいか
+	bool isValid() const { return headerValid; }
+	// 途中でデータが壊れていた/切れていたら true (以降 next() は false)
+	bool hasError() const { return error; }
+
+	// 次のレコードを fix に設定する。無ければ false
+	bool next(GPSFix &fix);
+
+	// 次に読む位置 (データ先頭からのバイト数)
+	size_t position() const { return pos; }
+	// キーフレームの位置へ移動する (GPSFixLogWriter::lastRecordOffset() の値など)
+	//  キーフレームでなければ false
+	bool seek(size_t offset);
+
+private:
+	const uint8_t *data;
+	size_t len;
+	size_t pos;
+	GPSFix prev;
+	bool headerValid;
+	bool synced;     // キーフレームを読んだか
+	bool error;
+};
+
+#endif // GPS_FIX_LOG_HPP
@@ -0,0 +1,385 @@
+#include "GPSGeodesy.hpp"
+
+#include <cmath>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+const double kPi = 3.14159265358979323846;
+const double kDegToRad = kPi / 180.0;
+const double kE7ToRad = kDegToRad * 1e-7;
+const double kE9ToRad = kDegToRad * 1e-9;
+
+//-----------------------------------------------------------------
+// double のベクトル型 (ISAごとに1つだけ有効)
+//  GPSVec: 値、GPSMask: 比較結果 (レーンごとに全ビット1/0)
+//-----------------------------------------------------------------
+#if defined(__AVX__)
+const size_t kLanes = 4;
+struct GPSVec { __m256d v; };
+struct GPSMask { __m256d m; };
+inline GPSVec vset(double x) { GPSVec r = { _mm256_set1_pd(x) }; return r; }
+inline GPSVec vload(const double *p) { GPSVec r = { _mm256_loadu_pd(p) }; return r; }
+inline void vstore(double *p, GPSVec a) { _mm256_storeu_pd(p, a.v); }
+inline GPSVec operator+(GPSVec a, GPSVec b) { GPSVec r = { _mm256_add_pd(a.v, b.v) }; return r; }
+inline GPSVec operator-(GPSVec a, GPSVec b) { GPSVec r = { _mm256_sub_pd(a.v, b.v) }; return r; }
+inline GPSVec operator*(GPSVec a, GPSVec b) { GPSVec r = { _mm256_mul_pd(a.v, b.v) }; return r; }
+inline GPSVec operator/(GPSVec a, GPSVec b) { GPSVec r = { _mm256_div_pd(a.v, b.v) }; return r; }
+inline GPSVec vsqrt(GPSVec a) { GPSVec r = { _mm256_sqrt_pd(a.v) }; return r; }
+inline GPSVec vmin(GPSVec a, GPSVec b) { GPSVec r = { _mm256_min_pd(a.v, b.v) }; return r; }
+inline GPSVec vmax(GPSVec a, GPSVec b) { GPSVec r = { _mm256_max_pd(a.v, b.v) }; return r; }
+inline GPSVec vabs(GPSVec a) { GPSVec r = { _mm256_andnot_pd(_mm256_set1_pd(-0.0), a.v) }; return r; }
+inline GPSMask vlt(GPSVec a, GPSVec b) { GPSMask r = { _mm256_cmp_pd(a.v, b.v, _CMP_LT_OQ) }; return r; }
+inline GPSMask vne(GPSVec a, GPSVec b) { GPSMask r = { _mm256_cmp_pd(a.v, b.v, _CMP_NEQ_UQ) }; return r; }
+inline GPSMask operator^(GPSMask a, GPSMask b) { GPSMask r = { _mm256_xor_pd(a.m, b.m) }; return r; }
+inline GPSVec vselect(GPSMask m, GPSVec a, GPSVec b) { GPSVec r = { _mm256_blendv_pd(b.v, a.v, m.m) }; return r; }
+#elif defined(__SSE2__)
+const size_t kLanes = 2;
+struct GPSVec { __m128d v; };
+struct GPSMask { __m128d m; };
+inline GPSVec vset(double x) { GPSVec r = { _mm_set1_pd(x) }; return r; }
+inline GPSVec vload(const double *p) { GPSVec r = { _mm_loadu_pd(p) }; return r; }
+inline void vstore(double *p, GPSVec a) { _mm_storeu_pd(p, a.v); }
+inline GPSVec operator+(GPSVec a, GPSVec b) { GPSVec r = { _mm_add_pd(a.v, b.v) }; return r; }
+inline GPSVec operator-(GPSVec a, GPSVec b) { GPSVec r = { _mm_sub_pd(a.v, b.v) }; return r; }
+inline GPSVec operator*(GPSVec a, GPSVec b) { GPSVec r = { _mm_mul_pd(a.v, b.v) }; return r; }
+inline GPSVec operator/(GPSVec a, GPSVec b) { GPSVec r = { _mm_div_pd(a.v, b.v) }; return r; }
+inline GPSVec vsqrt(GPSVec a) { GPSVec r = { _mm_sqrt_pd(a.v) }; return r; }
+inline GPSVec vmin(GPSVec a, GPSVec b) { GPSVec r = { _mm_min_pd(a.v, b.v) }; return r; }
+inline GPSVec vmax(GPSVec a, GPSVec b) { GPSVec r = { _mm_max_pd(a.v, b.v) }; return r; }
+inline GPSVec vabs(GPSVec a) { GPSVec r = { _mm_andnot_pd(_mm_set1_pd(-0.0), a.v) }; return r; }
+inline GPSMask vlt(GPSVec a, GPSVec b) { GPSMask r = { _mm_cmplt_pd(a.v, b.v) }; return r; }
+inline GPSMask vne(GPSVec a, GPSVec b) { GPSMask r = { _mm_cmpneq_pd(a.v, b.v) }; return r; }
+inline GPSMask operator^(GPSMask a, GPSMask b) { GPSMask r = { _mm_xor_pd(a.m, b.m) }; return r; }
+inline GPSVec vselect(GPSMask m, GPSVec a, GPSVec b) {
+	GPSVec r = { _mm_or_pd(_mm_and_pd(m.m, a.v), _mm_andnot_pd(m.m, b.v)) };
+	return r;
+}
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+const size_t kLanes = 2;
+struct GPSVec { float64x2_t v; };
+struct GPSMask { uint64x2_t m; };
+inline GPSVec vset(double x) { GPSVec r = { vdupq_n_f64(x) }; return r; }
+inline GPSVec vload(const double *p) { GPSVec r = { vld1q_f64(p) }; return r; }
+inline void vstore(double *p, GPSVec a) { vst1q_f64(p, a.v); }
+inline GPSVec operator+(GPSVec a, GPSVec b) { GPSVec r = { vaddq_f64(a.v, b.v) }; return r; }
+inline GPSVec operator-(GPSVec a, GPSVec b) { GPSVec r = { vsubq_f64(a.v, b.v) }; return r; }
+inline GPSVec operator*(GPSVec a, GPSVec b) { GPSVec r = { vmulq_f64(a.v, b.v) }; return r; }
+inline GPSVec operator/(GPSVec a, GPSVec b) { GPSVec r = { vdivq_f64(a.v, b.v) }; return r; }
+inline GPSVec vsqrt(GPSVec a) { GPSVec r = { vsqrtq_f64(a.v) }; return r; }
+inline GPSVec vmin(GPSVec a, GPSVec b) { GPSVec r = { vminq_f64(a.v, b.v) }; return r; }
+inline GPSVec vmax(GPSVec a, GPSVec b) { GPSVec r = { vmaxq_f64(a.v, b.v) }; return r; }
+inline GPSVec vabs(GPSVec a) { GPSVec r = { vabsq_f64(a.v) }; return r; }
+inline GPSMask vlt(GPSVec a, GPSVec b) { GPSMask r = { vcltq_f64(a.v, b.v) }; return r; }
+inline GPSMask vne(GPSVec a, GPSVec b) {
+	GPSMask r = { vreinterpretq_u64_u32(vmvnq_u32(vreinterpretq_u32_u64(vceqq_f64(a.v, b.v)))) };
+	return r;
+}
+inline GPSMask operator^(GPSMask a, GPSMask b) { GPSMask r = { veorq_u64(a.m, b.m) }; return r; }
+inline GPSVec vselect(GPSMask m, GPSVec a, GPSVec b) { GPSVec r = { vbslq_f64(m.m, a.v, b.v) }; return r; }
+#else
+// SIMD非対応環境では1レーンで、sin/cos/atan2 は libm を使う
+//  (AVR などの double が32bitの環境では、下の縮小と多項式は精度が足りない)
+#define GPSNMEA_GEODESY_LIBM 1
+const size_t kLanes = 1;
+struct GPSVec { double v; };
+struct GPSMask { bool m; };
+inline GPSVec vset(double x) { GPSVec r = { x }; return r; }
+inline GPSVec vload(const double *p) { GPSVec r = { *p }; return r; }
+inline void vstore(double *p, GPSVec a) { *p = a.v; }
+inline GPSVec operator+(GPSVec a, GPSVec b) { GPSVec r = { a.v + b.v }; return r; }
+inline GPSVec operator-(GPSVec a, GPSVec b) { GPSVec r = { a.v - b.v }; return r; }
+inline GPSVec operator*(GPSVec a, GPSVec b) { GPSVec r = { a.v * b.v }; return r; }
+inline GPSVec operator/(GPSVec a, GPSVec b) { GPSVec r = { a.v / b.v }; return r; }
+inline GPSVec vsqrt(GPSVec a) { GPSVec r = { std::sqrt(a.v) }; return r; }
+inline GPSVec vmin(GPSVec a, GPSVec b) { GPSVec r = { a.v < b.v ? a.v : b.v }; return r; }
+inline GPSVec vmax(GPSVec a, GPSVec b) { GPSVec r = { a.v > b.v ? a.v : b.v }; return r; }
+inline GPSVec vabs(GPSVec a) { GPSVec r = { std::fabs(a.v) }; return r; }
+inline GPSMask vlt(GPSVec a, GPSVec b) { GPSMask r = { a.v < b.v }; return r; }
+inline GPSMask vne(GPSVec a, GPSVec b) { GPSMask r = { a.v != b.v }; return r; }
+inline GPSMask operator^(GPSMask a, GPSMask b) { GPSMask r = { a.m != b.m }; return r; }
+inline GPSVec vselect(GPSMask m, GPSVec a, GPSVec b) { return m.m ? a : b; }
+#endif
+
+inline GPSVec operator-(GPSVec a) { return vset(0.0) - a; }
+
+#if defined(GPSNMEA_GEODESY_LIBM)
+inline void vsincos(GPSVec x, GPSVec &s, GPSVec &c) {
+	s.v = std::sin(x.v);
+	c.v = std::cos(x.v);
+}
+inline GPSVec vatan2(GPSVec y, GPSVec x) { GPSVec r = { std::atan2(y.v, x.v) }; return r; }
+#else
+// 最も近い整数へ丸める (|x| < 2^51、丸めモードは既定の最近接偶数)
+inline GPSVec vround(GPSVec x) {
+	const GPSVec magic = vset(6755399441055744.0);  // 1.5 * 2^52
+	return (x + magic) - magic;
+}
+
+//-----------------------------------------------------------------
+// sin と cos を同時に求める
+//  x = k * π/2 + r (|r| <= π/4) に縮小し、r の多項式 (fdlibm の係数) と
+//  象限 k mod 4 で組み立てる。π/2 は3分割して縮小時の誤差を抑える
+//-----------------------------------------------------------------
+inline void vsincos(GPSVec x, GPSVec &s, GPSVec &c) {
+	GPSVec k = vround(x * vset(2.0 / kPi));
+	GPSVec r = ((x - k * vset(1.57079625129699707031e+00))
+		- k * vset(7.54978941586159635335e-08))
+		- k * vset(5.39030285815811905290e-15);
+	GPSVec z = r * r;
+
+	GPSVec ps = vset(1.58969099521155010221e-10);
+	ps = ps * z + vset(-2.50507602534068634195e-08);
+	ps = ps * z + vset(2.75573137070700676789e-06);
+	ps = ps * z + vset(-1.98412698298579493134e-04);
+	ps = ps * z + vset(8.33333333332248946124e-03);
+	ps = ps * z + vset(-1.66666666666666324348e-01);
+	GPSVec sr = r + r * z * ps;
+
+	GPSVec pc = vset(-1.13596475577881948265e-11);
+	pc = pc * z + vset(2.08757232129817482790e-09);
+	pc = pc * z + vset(-2.75573143513906633035e-07);
+	pc = pc * z + vset(2.48015872894767294178e-05);
+	pc = pc * z + vset(-1.38888888888741095749e-03);
+	pc = pc * z + vset(4.16666666666666019037e-02);
+	GPSVec cr = vset(1.0) - vset(0.5) * z + z * z * pc;
+
+	// 象限: odd = k の bit0、high = k の bit1 (負の k も2の補数と同じ扱い)
+	GPSVec half = k * vset(0.5);
+	GPSMask odd = vne(half, vround(half));
+	GPSVec quarter = k * vset(0.25);
+	GPSVec fl = vround(quarter);
+	fl = vselect(vlt(quarter, fl), fl - vset(1.0), fl);
+	GPSMask high = vlt(vset(0.25), quarter - fl);  // 小数部が 0.5 か 0.75
+
+	GPSVec sinBase = vselect(odd, cr, sr);
+	GPSVec cosBase = vselect(odd, sr, cr);
+	s = vselect(high, -sinBase, sinBase);
+	c = vselect(odd ^ high, -cosBase, cosBase);
+}
+
+//-----------------------------------------------------------------
+// atan2(y, x)
+//  a = min(|x|,|y|) / max(|x|,|y|) (0..1) に縮小し、a > tan(π/8) なら
+//  π/4 + atan((a-1)/(a+1)) とする。多項式は Cephes atan の有理近似
+//-----------------------------------------------------------------
+inline GPSVec vatan2(GPSVec y, GPSVec x) {
+	GPSVec ax = vabs(x);
+	GPSVec ay = vabs(y);
+	GPSVec hi = vmax(ax, ay);
+	GPSVec lo = vmin(ax, ay);
+
+	// a = lo / hi として、a > tan(π/8) なら (a-1)/(a+1) = (lo-hi)/(lo+hi)。割り算は1回で済ませる
+	GPSMask big = vlt(vset(0.41421356237309504880) * hi, lo);
+	GPSVec num = vselect(big, lo - hi, lo);
+	GPSVec den = vselect(big, lo + hi, vmax(hi, vset(1e-300)));
+	GPSVec t = num / den;
+	GPSVec z = t * t;
+	GPSVec p = vset(-8.750608600031904122785e-01);
+	p = p * z + vset(-1.615753718733365076637e+01);
+	p = p * z + vset(-7.500855792314704667340e+01);
+	p = p * z + vset(-1.228866684490136173410e+02);
+	p = p * z + vset(-6.485021904942025371773e+01);
+	GPSVec q = z + vset(2.485846490142306297962e+01);
+	q = q * z + vset(1.650270098316988542046e+02);
+	q = q * z + vset(4.328810604912902668951e+02);
+	q = q * z + vset(4.853903996359136964868e+02);
+	q = q * z + vset(1.945506571482613964425e+02);
+	GPSVec r = t + t * z * p / q;
+	r = vselect(big, r + vset(kPi / 4), r);
+
+	r = vselect(vlt(ax, ay), vset(kPi / 2) - r, r);
+	r = vselect(vlt(x, vset(0.0)), vset(kPi) - r, r);
+	return vselect(vlt(y, vset(0.0)), -r, r);
+}
+#endif // GPSNMEA_GEODESY_LIBM
+
+//-----------------------------------------------------------------
+// 区間の入力 (緯度・経度差は整数のまま取り、経度差は ±180度 に折り返す)
+//-----------------------------------------------------------------
+struct GPSSegments {
+	GPSVec lat1, lat2, dLat, dLng;  // ラジアン
+};
+
+inline int64_t gpsWrapE7(int64_t d) {
+	if (d > 1800000000LL)
+		d -= 3600000000LL;
+	else if (d < -1800000000LL)
+		d += 3600000000LL;
+	return d;
+}
+
+// 区間をまとめて変換する単位。先にスカラーでラジアンの列へ展開してからベクトルで読む
+//  (レーンごとに書いた直後にベクトルで読むとストアフォワーディングが効かず遅い)
+//  1レーンの環境(MCUなど)ではスタックを使わないよう1区間ずつ
+const size_t kBlock = kLanes == 1 ? 1 : 64;
+static_assert(kBlock % kLanes == 0, "kBlock must be a multiple of kLanes");
+
+struct GPSSegmentBlock {
+	double lat1[kBlock];
+	double lat2[kBlock];
+	double dLat[kBlock];
+	double dLng[kBlock];
+};
+
+// 区間 i .. i + count - 1 を展開する (kLanes の端数は最後の区間で埋める)
+inline void expandSegments(const int32_t *latE7, const int32_t *lngE7, size_t i, size_t count, GPSSegmentBlock &b) {
+	size_t padded = (count + kLanes - 1) / kLanes * kLanes;
+	for (size_t j = 0; j < padded; ++j) {
+		size_t k = i + (j < count ? j : count - 1);
+		b.lat1[j] = latE7[k] * kE7ToRad;
+		b.lat2[j] = latE7[k + 1] * kE7ToRad;
+		b.dLat[j] = (static_cast<int64_t>(latE7[k + 1]) - latE7[k]) * kE7ToRad;
+		b.dLng[j] = gpsWrapE7(static_cast<int64_t>(lngE7[k + 1]) - lngE7[k]) * kE7ToRad;
+	}
+}
+
+inline void loadSegments(const GPSSegmentBlock &b, size_t j, GPSSegments &seg) {
+	seg.lat1 = vload(b.lat1 + j);
+	seg.lat2 = vload(b.lat2 + j);
+	seg.dLat = vload(b.dLat + j);
+	seg.dLng = vload(b.dLng + j);
+}
+
+inline void storeSegments(double *out, size_t count, GPSVec v) {
+	if (count >= kLanes) {
+		vstore(out, v);
+	} else {
+		double tmp[kLanes];
+		vstore(tmp, v);
+		for (size_t j = 0; j < count; ++j)
+			out[j] = tmp[j];
+	}
+}
+
+// φ2 = φ1 + Δφ の sin/cos は加法定理で求め、sin/cos の計算を1組減らす
+inline GPSVec haversine(const GPSSegments &seg) {
+	GPSVec sLat, cLat, sLng, cLng, s1, c1;
+	vsincos(seg.dLat * vset(0.5), sLat, cLat);
+	vsincos(seg.dLng * vset(0.5), sLng, cLng);
+	vsincos(seg.lat1, s1, c1);
+	// cos Δφ = 1 - 2 sin²(Δφ/2), sin Δφ = 2 sin(Δφ/2) cos(Δφ/2)
+	GPSVec c2 = c1 * (vset(1.0) - vset(2.0) * sLat * sLat) - s1 * vset(2.0) * sLat * cLat;
+	GPSVec h = sLat * sLat + c1 * c2 * sLng * sLng;
+	h = vmin(vmax(h, vset(0.0)), vset(1.0));
+	return vset(2.0 * GPS_EARTH_RADIUS_M) * vatan2(vsqrt(h), vsqrt(vset(1.0) - h));
+}
+
+inline GPSVec equirectangular(const GPSSegments &seg) {
+	GPSVec s, c;
+	vsincos((seg.lat1 + seg.lat2) * vset(0.5), s, c);
+	GPSVec x = seg.dLng * c;
+	return vset(GPS_EARTH_RADIUS_M) * vsqrt(x * x + seg.dLat * seg.dLat);
+}
+
+inline GPSVec bearing(const GPSSegments &seg) {
+	GPSVec sLng, cLng, s1, c1, sd, cd;
+	vsincos(seg.dLng, sLng, cLng);
+	vsincos(seg.lat1, s1, c1);
+	vsincos(seg.dLat, sd, cd);
+	GPSVec s2 = s1 * cd + c1 * sd;
+	GPSVec c2 = c1 * cd - s1 * sd;
+	GPSVec y = sLng * c2;
+	GPSVec x = c1 * s2 - s1 * c2 * cLng;
+	GPSVec deg = vatan2(y, x) * vset(180.0 / kPi);
+	return vselect(vlt(deg, vset(0.0)), deg + vset(360.0), deg);
+}
+
+template <GPSVec (*Kernel)(const GPSSegments &)>
+void forEachSegment(const int32_t *latE7, const int32_t *lngE7, size_t n, double *out) {
+	if (n < 2)
+		return;
+	size_t segments = n - 1;
+	GPSSegmentBlock block;
+	GPSSegments seg;
+	for (size_t i = 0; i < segments; i += kBlock) {
+		size_t count = segments - i < kBlock ? segments - i : kBlock;
+		expandSegments(latE7, lngE7, i, count, block);
+		for (size_t j = 0; j < count; j += kLanes) {
+			loadSegments(block, j, seg);
+			storeSegments(out + i + j, count - j, Kernel(seg));
+		}
+	}
+}
+
+//-----------------------------------------------------------------
+// RawDegrees -> 1e-9度単位の符号付き整数
+//-----------------------------------------------------------------
+inline int64_t gpsNanoDegrees(const RawDegrees &d) {
+	int64_t v = static_cast<int64_t>(d.deg) * 1000000000LL + d.billionths;
+	return d.negative ? -v : v;
+}
+
+inline int64_t gpsWrapE9(int64_t d) {
+	if (d > 180000000000LL)
+		d -= 360000000000LL;
+	else if (d < -180000000000LL)
+		d += 360000000000LL;
+	return d;
+}
+
+} // namespace
+
+//-----------------------------------
+// 1区間
+//-----------------------------------
+double gpsDistanceBetween(const RawDegrees &lat1, const RawDegrees &lng1,
+	const RawDegrees &lat2, const RawDegrees &lng2) {
+	int64_t la1 = gpsNanoDegrees(lat1);
+	int64_t la2 = gpsNanoDegrees(lat2);
+	double dLat = (la2 - la1) * kE9ToRad;
+	double dLng = gpsWrapE9(gpsNanoDegrees(lng2) - gpsNanoDegrees(lng1)) * kE9ToRad;
+	double sLat = std::sin(dLat * 0.5);
+	double sLng = std::sin(dLng * 0.5);
+	double h = sLat * sLat + std::cos(la1 * kE9ToRad) * std::cos(la2 * kE9ToRad) * sLng * sLng;
+	if (h > 1.0)
+		h = 1.0;
+	return 2.0 * GPS_EARTH_RADIUS_M * std::atan2(std::sqrt(h), std::sqrt(1.0 - h));
+}
+
+double gpsCourseTo(const RawDegrees &lat1, const RawDegrees &lng1,
+	const RawDegrees &lat2, const RawDegrees &lng2) {
+	double phi1 = gpsNanoDegrees(lat1) * kE9ToRad;
+	double phi2 = gpsNanoDegrees(lat2) * kE9ToRad;
+	double dLng = gpsWrapE9(gpsNanoDegrees(lng2) - gpsNanoDegrees(lng1)) * kE9ToRad;
+	double y = std::sin(dLng) * std::cos(phi2);
+	double x = std::cos(phi1) * std::sin(phi2) - std::sin(phi1) * std::cos(phi2) * std::cos(dLng);
+	double deg = std::atan2(y, x) * (180.0 / kPi);
+	return deg < 0 ? deg + 360.0 : deg;
+}
+
+//-----------------------------------
+// 点列の一括計算
+//-----------------------------------
+void gpsHaversineDistances(const int32_t *latE7, const int32_t *lngE7, size_t n, double *out) {
+	forEachSegment<haversine>(latE7, lngE7, n, out);
+}
+
+void gpsEquirectangularDistances(const int32_t *latE7, const int32_t *lngE7, size_t n, double *out) {
+	forEachSegment<equirectangular>(latE7, lngE7, n, out);
+}
+
+void gpsBearings(const int32_t *latE7, const int32_t *lngE7, size_t n, double *out) {
+	forEachSegment<bearing>(latE7, lngE7, n, out);
+}
+
+double gpsCumulativeDistances(const int32_t *latE7, const int32_t *lngE7, size_t n, double *out) {
+	if (n == 0)
+		return 0.0;
+	// 区間距離を out[1..] に書いてから前から足し込む
+	gpsHaversineDistances(latE7, lngE7, n, out + 1);
+	out[0] = 0.0;
+	double total = 0.0;
+	for (size_t i = 1; i < n; ++i) {
+		total += out[i];
+		out[i] = total;
+	}
+	return total;
+}
@@ -0,0 +1,48 @@
+#ifndef GPS_GEODESY_HPP
+#define GPS_GEODESY_HPP
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "GPSNMEA.hpp"
+
+//=================================================================
+// 距離・方位の計算 (地球を半径 GPS_EARTH_RADIUS_M の球とみなす)
+//=================================================================
+
+// 地球の平均半径 (IUGG, m)
+static const double GPS_EARTH_RADIUS_M = 6371008.8;
+
+// ------------------------------
+// 1区間 (RawDegrees のまま計算)
+//  緯度差・経度差は 1e-9 度単位の整数で取るので、近い2点でも桁落ちしない
+// ------------------------------
+
+// 2点間の大円距離 (m, haversine)
+double gpsDistanceBetween(const RawDegrees &lat1, const RawDegrees &lng1,
+	const RawDegrees &lat2, const RawDegrees &lng2);
+
+// 点1から点2への初期方位 (度, 北=0 時計回り 0-360)
+double gpsCourseTo(const RawDegrees &lat1, const RawDegrees &lng1,
+	const RawDegrees &lat2, const RawDegrees &lng2);
+
+// ------------------------------
+// 連続する点列の一括計算 (GPSFix / GPSTrack の 1e-7度単位の列をそのまま渡す)
+//  n 点から n - 1 区間を計算し、out[i] に点 i -> i + 1 の値を書く
+//  AVX/SSE2/NEON(AArch64) が使える環境では複数区間をまとめて計算する
+//  (sin/cos/atan は libm を呼ばず、π/2 で範囲縮小した多項式で求める)
+// ------------------------------
+
+// 大円距離 (m, haversine)
+void gpsHaversineDistances(const int32_t *latE7, const int32_t *lngE7, size_t n, double *out);
+
+// 正距円筒図法による近似距離 (m)。数km以内の区間なら haversine と十分一致し、より軽い
+void gpsEquirectangularDistances(const int32_t *latE7, const int32_t *lngE7, size_t n, double *out);
+
+// 初期方位 (度, 0-360)
+void gpsBearings(const int32_t *latE7, const int32_t *lngE7, size_t n, double *out);
+
+// 先頭からの累積距離 (m, haversine)。out[0] = 0 で n 個書き、総距離を返す
+double gpsCumulativeDistances(const int32_t *latE7, const int32_t *lngE7, size_t n, double *out);
+
+#endif // GPS_GEODESY_HPP
@@ -1,9 +1,48 @@
 #include "GPSNMEA.hpp"
+#include "GPSNMEAView.hpp"
+#if GPSNMEA_HOST
+#include <chrono>
+#else
 #include <Arduino.h>
+#endif
 #include <cstdlib>
 #include <cctype>
+#include <cstdarg>
+#include <cstdio>
 #include <cmath>
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+unsigned long gpsMillis() {
+#if GPSNMEA_HOST
+	// 最初の呼び出しを起点とした経過時間 (millis() と同じく起動時刻基準)
+	static const std::chrono::steady_clock::time_point origin = std::chrono::steady_clock::now();
+	return static_cast<unsigned long>(std::chrono::duration_cast<std::chrono::milliseconds>(
+		std::chrono::steady_clock::now() - origin).count());
+#else
+	return millis();
+#endif
+}
+
+#if GPSNMEA_INSTRUMENTATION
+// 計測用の時計 (ホストビルドではナノ秒、Arduino ではマイクロ秒。32bitで周回する)
+//  差分だけを使うので周回は問題にならない (1センテンスに4秒以上かからない限り)
+static inline uint32_t gpsStatTicks() {
+#if GPSNMEA_HOST
+	return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count());
+#else
+	return micros();
+#endif
+}
+#endif
+
 int gpsFromHex(char a) {
 	if (a >= 'A' && a <= 'F')
 		return a - 'A' + 10;
@@ -12,32 +51,61 @@ int gpsFromHex(char a) {
 	return a - '0';
 }
 
-int32_t gpsParseDecimal(const char *term) {
+// 1文字を数字として読む。数字でなければ 9 より大きい値になる
+static inline unsigned gpsDigit(char c) {
+	return static_cast<unsigned>(static_cast<unsigned char>(c)) - '0';
+}
+
+int32_t gpsParseFixed(const char *term, uint8_t fracDigits) {
 	bool negative = (*term == '-');
 	if (negative) ++term;
-	int32_t ret = 100 * static_cast<int32_t>(atol(term));
-	while (isdigit(*term)) ++term;
-	if (*term == '.' && isdigit(term[1])) {
-		ret += 10 * (term[1] - '0');
-		if (isdigit(term[2])) {
-			ret += (term[2] - '0');
+
+	// 整数部と小数部を1回の走査で読み、fracDigits 桁に揃える (それ以降は切り捨て)
+	uint32_t ret = 0;
+	unsigned d;
+	while ((d = gpsDigit(*term)) <= 9) {
+		ret = ret * 10 + d;
+		++term;
+	}
+	uint8_t n = 0;
+	if (*term == '.') {
+		++term;
+		while (n < fracDigits && (d = gpsDigit(*term)) <= 9) {
+			ret = ret * 10 + d;
+			++term;
+			++n;
 		}
 	}
-	return negative ? -ret : ret;
+	for (; n < fracDigits; ++n)
+		ret *= 10;
+	return negative ? -static_cast<int32_t>(ret) : static_cast<int32_t>(ret);
+}
+
+int32_t gpsParseInt(const char *term) {
+	return gpsParseFixed(term, 0);
+}
+
+int32_t gpsParseDecimal(const char *term) {
+	return gpsParseFixed(term, 2);
 }
 
 void gpsParseDegrees(const char *term, RawDegrees &deg) {
-	uint32_t leftOfDecimal = static_cast<uint32_t>(atol(term));
-	uint16_t minutes = static_cast<uint16_t>(leftOfDecimal % 100);
+	// "dddmm.mmmm" を1回の走査で読む
+	uint32_t leftOfDecimal = 0;
+	unsigned d;
+	while ((d = gpsDigit(*term)) <= 9) {
+		leftOfDecimal = leftOfDecimal * 10 + d;
+		++term;
+	}
 	uint32_t multiplier = 10000000UL;
-	uint32_t tenMillionths = minutes * multiplier;
+	uint32_t tenMillionths = (leftOfDecimal % 100) * multiplier;
 	deg.deg = leftOfDecimal / 100;
 
-	while (isdigit(*term)) ++term;
 	if (*term == '.') {
-		while (isdigit(*++term)) {
+		// 小数点以下7桁まで (それ以降は multiplier が0になり無視される)
+		while ((d = gpsDigit(*++term)) <= 9 && multiplier > 1) {
 			multiplier /= 10;
-			tenMillionths += (term[0] - '0') * multiplier;
+			tenMillionths += d * multiplier;
 		}
 	}
 	// TinyGPS++ の実装に準拠 (60分=1度 など計算)
@@ -45,14 +113,755 @@ void gpsParseDegrees(const char *term, RawDegrees &deg) {
 	deg.negative = false;
 }
 
+int32_t gpsDaysFromCivil(int32_t year, unsigned month, unsigned day) {
+	// 3月始まりの年に直し、400年周期で数える
+	year -= month <= 2;
+	const int32_t era = (year >= 0 ? year : year - 399) / 400;
+	const unsigned yoe = static_cast<unsigned>(year - era * 400);             // [0, 399]
+	const unsigned doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;  // [0, 365]
+	const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;               // [0, 146096]
+	return era * 146097 + static_cast<int32_t>(doe) - 719468;
+}
+
+bool gpsDateToDays(uint32_t date, int32_t &days) {
+	unsigned dd = date / 10000;
+	unsigned mm = (date / 100) % 100;
+	if (dd < 1 || dd > 31 || mm < 1 || mm > 12)
+		return false;
+	days = gpsDaysFromCivil(gpsFullYear(date % 100), mm, dd);
+	return true;
+}
+
+int64_t gpsEpochMillis(uint32_t date, uint32_t time) {
+	int32_t days = 0;
+	gpsDateToDays(date, days);
+	return static_cast<int64_t>(days) * 86400000 + gpsMillisOfDay(time);
+}
+
+int32_t gpsDegreesE7(const RawDegrees &deg) {
+	int32_t v = static_cast<int32_t>(deg.deg) * 10000000L +
+		static_cast<int32_t>((deg.billionths + 50) / 100);
+	return deg.negative ? -v : v;
+}
+
+void gpsDegreesFromE7(int32_t e7, RawDegrees &deg) {
+	uint32_t u = e7 < 0 ? 0u - static_cast<uint32_t>(e7) : static_cast<uint32_t>(e7);
+	deg.deg = static_cast<uint8_t>(u / 10000000UL);
+	deg.billionths = (u % 10000000UL) * 100;
+	deg.negative = e7 < 0;
+}
+
+static const char* const cardinalDirections[] = {
+	"N", "NNE", "NE", "ENE", "E", "ESE", "SE", "SSE",
+	"S", "SSW", "SW", "WSW", "W", "WNW", "NW", "NNW"
+};
+
+#if !GPSNMEA_NO_DOUBLE
 const char* gpsCardinal(double course) {
-	static const char* directions[] = {
-		"N", "NNE", "NE", "ENE", "E", "ESE", "SE", "SSE",
-		"S", "SSW", "SW", "WSW", "W", "WNW", "NW", "NNW"
-	};
 	int index = static_cast<int>((course + 11.25) / 22.5);
-	return directions[index % 16];
+	return cardinalDirections[index % 16];
+}
+#endif
+
+const char* gpsCardinalX100(int32_t course) {
+	// 負の値や360度以上も [0, 36000) に畳んでから 22.5度(2250)ごとに区切る
+	int32_t c = course % 36000;
+	if (c < 0)
+		c += 36000;
+	return cardinalDirections[((c + 1125) / 2250) % 16];
+}
+
+// UBXフレームの同期文字の1バイト目と、RTCM3 フレームのプリアンブル
+static const char kUbxSync1 = static_cast<char>(0xB5);
+static const char kRtcmPreamble = static_cast<char>(0xD3);
+
+// Ubx/Rtcm が true なら、それぞれのフレームの先頭 (0xB5, 0xD3) も区切りとして探す (encode() 用)
+template <bool Ubx, bool Rtcm>
+static inline bool gpsIsDelimiter(char c) {
+	return c == '$' || c == ',' || c == '*' || c == '\r' || c == '\n' ||
+		(Ubx && c == kUbxSync1) || (Rtcm && c == kRtcmPreamble);
+}
+
+template <bool Ubx, bool Rtcm>
+static inline const char* gpsScanDelimiter(const char *p, const char *end) {
+#if defined(__AVX2__)
+	const __m256i dDollar = _mm256_set1_epi8('$');
+	const __m256i dComma  = _mm256_set1_epi8(',');
+	const __m256i dStar   = _mm256_set1_epi8('*');
+	const __m256i dCR     = _mm256_set1_epi8('\r');
+	const __m256i dLF     = _mm256_set1_epi8('\n');
+	const __m256i dSync   = _mm256_set1_epi8(kUbxSync1);
+	const __m256i dRtcm   = _mm256_set1_epi8(kRtcmPreamble);
+	while (end - p >= 32) {
+		__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+		__m256i m = _mm256_or_si256(
+			_mm256_or_si256(_mm256_cmpeq_epi8(v, dDollar), _mm256_cmpeq_epi8(v, dComma)),
+			_mm256_or_si256(_mm256_cmpeq_epi8(v, dStar),
+				_mm256_or_si256(_mm256_cmpeq_epi8(v, dCR), _mm256_cmpeq_epi8(v, dLF))));
+		if (Ubx)
+			m = _mm256_or_si256(m, _mm256_cmpeq_epi8(v, dSync));
+		if (Rtcm)
+			m = _mm256_or_si256(m, _mm256_cmpeq_epi8(v, dRtcm));
+		uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(m));
+		if (mask != 0)
+			return p + __builtin_ctz(mask);
+		p += 32;
+	}
+#elif defined(__SSE2__)
+	const __m128i dDollar = _mm_set1_epi8('$');
+	const __m128i dComma  = _mm_set1_epi8(',');
+	const __m128i dStar   = _mm_set1_epi8('*');
+	const __m128i dCR     = _mm_set1_epi8('\r');
+	const __m128i dLF     = _mm_set1_epi8('\n');
+	const __m128i dSync   = _mm_set1_epi8(kUbxSync1);
+	const __m128i dRtcm   = _mm_set1_epi8(kRtcmPreamble);
+	while (end - p >= 16) {
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+		__m128i m = _mm_or_si128(
+			_mm_or_si128(_mm_cmpeq_epi8(v, dDollar), _mm_cmpeq_epi8(v, dComma)),
+			_mm_or_si128(_mm_cmpeq_epi8(v, dStar),
+				_mm_or_si128(_mm_cmpeq_epi8(v, dCR), _mm_cmpeq_epi8(v, dLF))));
+		if (Ubx)
+			m = _mm_or_si128(m, _mm_cmpeq_epi8(v, dSync));
+		if (Rtcm)
+			m = _mm_or_si128(m, _mm_cmpeq_epi8(v, dRtcm));
+		int mask = _mm_movemask_epi8(m);
+		if (mask != 0)
+			return p + __builtin_ctz(static_cast<unsigned>(mask));
+		p += 16;
+	}
+#elif defined(__ARM_NEON)
+	const uint8x16_t dDollar = vdupq_n_u8('$');
+	const uint8x16_t dComma  = vdupq_n_u8(',');
+	const uint8x16_t dStar   = vdupq_n_u8('*');
+	const uint8x16_t dCR     = vdupq_n_u8('\r');
+	const uint8x16_t dLF     = vdupq_n_u8('\n');
+	const uint8x16_t dSync   = vdupq_n_u8(0xB5);
+	const uint8x16_t dRtcm   = vdupq_n_u8(0xD3);
+	while (end - p >= 16) {
+		uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(p));
+		uint8x16_t m = vorrq_u8(
+			vorrq_u8(vceqq_u8(v, dDollar), vceqq_u8(v, dComma)),
+			vorrq_u8(vceqq_u8(v, dStar), vorrq_u8(vceqq_u8(v, dCR), vceqq_u8(v, dLF))));
+		if (Ubx)
+			m = vorrq_u8(m, vceqq_u8(v, dSync));
+		if (Rtcm)
+			m = vorrq_u8(m, vceqq_u8(v, dRtcm));
+		uint8x8_t folded = vorr_u8(vget_low_u8(m), vget_high_u8(m));
+		if (vget_lane_u64(vreinterpret_u64_u8(folded), 0) != 0)
+			break;  // このブロック内にあるので残りはスカラーで特定
+		p += 16;
+	}
+#endif
+	// スカラー版 (SIMD非対応環境、または端数部分)
+	while (p < end && !gpsIsDelimiter<Ubx, Rtcm>(*p))
+		++p;
+	return p;
+}
+
+const char* gpsFindDelimiter(const char *p, const char *end) {
+	return gpsScanDelimiter<false, false>(p, end);
+}
+
+uint8_t gpsXorBytes(const char *p, size_t len) {
+	// 4バイト単位でXORしてから畳み込む
+	uint32_t acc = 0;
+	while (len >= 4) {
+		uint32_t w;
+		memcpy(&w, p, sizeof(w));
+		acc ^= w;
+		p += 4;
+		len -= 4;
+	}
+	acc ^= acc >> 16;
+	acc ^= acc >> 8;
+	uint8_t x = static_cast<uint8_t>(acc);
+	while (len--)
+		x ^= static_cast<uint8_t>(*p++);
+	return x;
+}
+
+//=================================================================
+// アドレスフィールドの完全ハッシュ分類
+//  トーカー2文字・センテンス3文字をそれぞれ整数に詰め、乗算ハッシュで
+//  16スロットの表を1回引くだけで判定する。表の並びはコンパイル時に検証する
+//=================================================================
+namespace {
+
+constexpr uint32_t gpsPackId(char a, char b, char c) {
+	return (static_cast<uint32_t>(static_cast<uint8_t>(a)) << 16) |
+		(static_cast<uint32_t>(static_cast<uint8_t>(b)) << 8) |
+		static_cast<uint32_t>(static_cast<uint8_t>(c));
+}
+
+// 全センテンス・全トーカーが衝突しないよう選んだ乗数
+constexpr uint32_t kSentenceHashMul = 0xDE049695UL;
+constexpr uint32_t kTalkerHashMul   = 0x78E51061UL;
+
+constexpr unsigned sentenceSlot(uint32_t key) {
+	return static_cast<uint32_t>(key * kSentenceHashMul) >> 28;
+}
+constexpr unsigned talkerSlot(uint32_t key) {
+	return static_cast<uint32_t>(key * kTalkerHashMul) >> 28;
+}
+
+struct SentenceSlot {
+	uint32_t key;
+	GPSNMEA::SentenceType type;
+};
+struct TalkerSlot {
+	uint32_t key;
+	GPSNMEA::Talker talker;
+};
+
+#define GPSNMEA_EMPTY_SENTENCE { 0, GPSNMEA::SentenceType_Other }
+constexpr SentenceSlot kSentenceTable[16] = {
+	/*  0 */ { gpsPackId('G', 'L', 'L'), GPSNMEA::SentenceType_GLL },
+	/*  1 */ { gpsPackId('G', 'S', 'T'), GPSNMEA::SentenceType_GST },
+	/*  2 */ { gpsPackId('G', 'N', 'S'), GPSNMEA::SentenceType_GNS },
+	/*  3 */ GPSNMEA_EMPTY_SENTENCE,
+	/*  4 */ GPSNMEA_EMPTY_SENTENCE,
+	/*  5 */ GPSNMEA_EMPTY_SENTENCE,
+	/*  6 */ { gpsPackId('G', 'G', 'A'), GPSNMEA::SentenceType_GGA },
+	/*  7 */ GPSNMEA_EMPTY_SENTENCE,
+	/*  8 */ { gpsPackId('Z', 'D', 'A'), GPSNMEA::SentenceType_ZDA },
+	/*  9 */ { gpsPackId('G', 'S', 'A'), GPSNMEA::SentenceType_GSA },
+	/* 10 */ { gpsPackId('V', 'T', 'G'), GPSNMEA::SentenceType_VTG },
+	/* 11 */ { gpsPackId('R', 'M', 'C'), GPSNMEA::SentenceType_RMC },
+	/* 12 */ GPSNMEA_EMPTY_SENTENCE,
+	/* 13 */ { gpsPackId('G', 'S', 'V'), GPSNMEA::SentenceType_GSV },
+	/* 14 */ { gpsPackId('G', 'B', 'S'), GPSNMEA::SentenceType_GBS },
+	/* 15 */ GPSNMEA_EMPTY_SENTENCE,
+};
+#undef GPSNMEA_EMPTY_SENTENCE
+
+#define GPSNMEA_EMPTY_TALKER { 0, GPSNMEA::Talker_Unknown }
+constexpr TalkerSlot kTalkerTable[16] = {
+	/*  0 */ { gpsPackId(0, 'G', 'I'), GPSNMEA::Talker_GI },
+	/*  1 */ GPSNMEA_EMPTY_TALKER,
+	/*  2 */ { gpsPackId(0, 'B', 'D'), GPSNMEA::Talker_BD },
+	/*  3 */ { gpsPackId(0, 'G', 'A'), GPSNMEA::Talker_GA },
+	/*  4 */ { gpsPackId(0, 'G', 'P'), GPSNMEA::Talker_GP },
+	/*  5 */ { gpsPackId(0, 'G', 'N'), GPSNMEA::Talker_GN },
+	/*  6 */ { gpsPackId(0, 'G', 'L'), GPSNMEA::Talker_GL },
+	/*  7 */ GPSNMEA_EMPTY_TALKER,
+	/*  8 */ GPSNMEA_EMPTY_TALKER,
+	/*  9 */ { gpsPackId(0, 'N', 'P'), GPSNMEA::Talker_GP }, // 旧版との互換のため受け付ける (GP と同じ扱い)
+	/* 10 */ { gpsPackId(0, 'N', 'N'), GPSNMEA::Talker_GN }, // 同上 (GN と同じ扱い)
+	/* 11 */ { gpsPackId(0, 'G', 'B'), GPSNMEA::Talker_GB },
+	/* 12 */ { gpsPackId(0, 'G', 'Q'), GPSNMEA::Talker_GQ },
+	/* 13 */ GPSNMEA_EMPTY_TALKER,
+	/* 14 */ GPSNMEA_EMPTY_TALKER,
+	/* 15 */ { gpsPackId(0, 'Q', 'Z'), GPSNMEA::Talker_QZ },
+};
+#undef GPSNMEA_EMPTY_TALKER
+
+// 各エントリが自分のハッシュ値のスロットに置かれているか
+constexpr bool sentenceTableValid(unsigned i) {
+	return i >= 16 || ((kSentenceTable[i].key == 0 || sentenceSlot(kSentenceTable[i].key) == i) &&
+		sentenceTableValid(i + 1));
+}
+constexpr bool talkerTableValid(unsigned i) {
+	return i >= 16 || ((kTalkerTable[i].key == 0 || talkerSlot(kTalkerTable[i].key) == i) &&
+		talkerTableValid(i + 1));
+}
+static_assert(GPSNMEA_SENTENCE_RMC == (1UL << GPSNMEA::SentenceType_RMC) &&
+	GPSNMEA_SENTENCE_GGA == (1UL << GPSNMEA::SentenceType_GGA) &&
+	GPSNMEA_SENTENCE_GSA == (1UL << GPSNMEA::SentenceType_GSA) &&
+	GPSNMEA_SENTENCE_GSV == (1UL << GPSNMEA::SentenceType_GSV) &&
+	GPSNMEA_SENTENCE_VTG == (1UL << GPSNMEA::SentenceType_VTG) &&
+	GPSNMEA_SENTENCE_GLL == (1UL << GPSNMEA::SentenceType_GLL) &&
+	GPSNMEA_SENTENCE_ZDA == (1UL << GPSNMEA::SentenceType_ZDA) &&
+	GPSNMEA_SENTENCE_GST == (1UL << GPSNMEA::SentenceType_GST) &&
+	GPSNMEA_SENTENCE_GNS == (1UL << GPSNMEA::SentenceType_GNS) &&
+	GPSNMEA_SENTENCE_GBS == (1UL << GPSNMEA::SentenceType_GBS) &&
+	GPSNMEA_SENTENCE_NAVPVT == (1UL << GPSNMEA::SentenceType_NAVPVT) &&
+	GPSNMEA_SENTENCE_NAVSAT == (1UL << GPSNMEA::SentenceType_NAVSAT),
+	"GPSNMEA_SENTENCE_xxx must match GPSNMEA::SentenceType");
+static_assert(sentenceTableValid(0), "kSentenceTable: entry is not in its hash slot");
+static_assert(talkerTableValid(0), "kTalkerTable: entry is not in its hash slot");
+
+} // namespace
+
+GPSNMEA::SentenceType GPSNMEA::classifyAddress(const char *address, size_t len, Talker &talker) {
+	talker = Talker_Unknown;
+	if (len != 5)
+		return SentenceType_Other;
+
+	uint32_t talkerKey = gpsPackId(0, address[0], address[1]);
+	const TalkerSlot &t = kTalkerTable[talkerSlot(talkerKey)];
+	if (t.key != talkerKey)
+		return SentenceType_Other;
+	talker = t.talker;
+
+	uint32_t sentenceKey = gpsPackId(address[2], address[3], address[4]);
+	const SentenceSlot &s = kSentenceTable[sentenceSlot(sentenceKey)];
+	return (s.key == sentenceKey) ? s.type : SentenceType_Other;
+}
+
+//=================================================================
+// センテンスのスキーマ
+//  センテンス種別ごとに「term番号 -> フィールドパーサと格納先」の constexpr 表を持つ。
+//  handleTerm() は種別と term番号で表を1回引いて呼ぶだけで、種別ごとの switch は無い。
+//  GPSNMEA_SENTENCES に含まれない種別は表ごと空になり、そのパーサ関数もリンクされない
+//=================================================================
+
+// フィールドパーサ (term と表の arg を受け取り、GPSNMEA の格納先へ書く)
+struct GPSNMEAFields {
+	// 時刻・日付・位置
+	static void time(GPSNMEA &gps, const char *term, uint8_t) { gps.time.setTime(term); }
+	static void date(GPSNMEA &gps, const char *term, uint8_t) { gps.date.setDate(term); }
+	static void latitude(GPSNMEA &gps, const char *term, uint8_t) { gps.location.setLatitude(term); }
+	static void longitude(GPSNMEA &gps, const char *term, uint8_t) { gps.location.setLongitude(term); }
+	static void northSouth(GPSNMEA &gps, const char *term, uint8_t) {
+		gps.location.rawNewLatData.negative = (term[0] == 'S');
+	}
+	static void eastWest(GPSNMEA &gps, const char *term, uint8_t) {
+		gps.location.rawNewLngData.negative = (term[0] == 'W');
+	}
+
+	// 測位の有無
+	//  status: RMC/GLL の 'A'(有効)/'V'(無効)
+	static void status(GPSNMEA &gps, const char *term, uint8_t) { gps.sentenceHasFix = (term[0] == 'A'); }
+	//  quality: GGA の品質 (0 は測位なし)
+	static void quality(GPSNMEA &gps, const char *term, uint8_t) { gps.sentenceHasFix = (term[0] > '0'); }
+	//  GLL のモード (NMEA 2.3 以降)。'N' なら status が 'A' でも無効
+	static void modeIndicator(GPSNMEA &gps, const char *term, uint8_t) {
+		if (term[0] == 'N')
+			gps.sentenceHasFix = false;
+	}
+	//  GNS のモード (衛星系ごとに1文字。どれかが 'N' 以外なら測位あり)
+	static void gnsMode(GPSNMEA &gps, const char *term, uint8_t) {
+		bool fix = false;
+		for (const char *p = term; *p >= 'A' && *p <= 'Z'; ++p)
+			fix |= (*p != 'N');
+		gps.sentenceHasFix = fix;
+	}
+
+	// GPSDecimal/GPSInteger 型のメンバへ (speed, hdop, satellites など)
+	template <GPSDecimal GPSNMEA::*Member>
+	static void decimal(GPSNMEA &gps, const char *term, uint8_t) { (gps.*Member).set(term); }
+	template <GPSInteger GPSNMEA::*Member>
+	static void integer(GPSNMEA &gps, const char *term, uint8_t) { (gps.*Member).set(term); }
+
+	// gsa, vtg などの構造体のメンバへ
+	//  fixed: 10^arg 倍の固定小数点、number: 整数
+	template <class Group, Group GPSNMEA::*G, class T, T Group::*M>
+	static void fixed(GPSNMEA &gps, const char *term, uint8_t arg) {
+		(gps.*G).*M = static_cast<T>(gpsParseFixed(term, arg));
+	}
+	template <class Group, Group GPSNMEA::*G, class T, T Group::*M>
+	static void number(GPSNMEA &gps, const char *term, uint8_t) {
+		(gps.*G).*M = static_cast<T>(gpsParseInt(term));
+	}
+
+	// GSA: モード ('A'/'M') と、arg 番目の衛星PRN
+	static void gsaMode(GPSNMEA &gps, const char *term, uint8_t) {
+		if (term[0] != '\0')
+			gps.gsa.mode = term[0];
+	}
+	static void gsaPrn(GPSNMEA &gps, const char *term, uint8_t arg) { gps.gsa.satPrn[arg] = gpsParseInt(term); }
+
+	// GSV: arg = 衛星番号 x4 + 項目 (PRN, 仰角, 方位角, SNR)
+	static void gsvSatellite(GPSNMEA &gps, const char *term, uint8_t arg) {
+		int v = gpsParseInt(term);
+		auto &sat = gps.gsv.satellites[arg >> 2];
+		switch (arg & 3) {
+			case 0: sat.prn = v; break;
+			case 1: sat.elevation = v; break;
+			case 2: sat.azimuth = v; break;
+			default: sat.snr = v; break;
+		}
+	}
+	static void beginGSV(GPSNMEA &gps) {
+		// 空欄(未追尾のSNRなど)に前ページの値が残らないようにする
+		memset(gps.gsv.satellites, 0, sizeof(gps.gsv.satellites));
+		gps.gsv.signalId = 0;
+	}
+
+	// チェックサム一致時のcommit。commit した項目 (Field_xxx のビット和) を返す
+	static uint16_t commitRMC(GPSNMEA &gps) {
+		gps.date.commit();
+		gps.time.commit();
+		gps.dateMillisOfDay = gps.time.millisOfDay();
+		if (gps.sentenceHasFix)
+			gps.location.commit();
+		gps.speed.commit();
+		gps.course.commit();
+		return GPSNMEA::Field_Date | GPSNMEA::Field_Time | GPSNMEA::Field_Speed | GPSNMEA::Field_Course |
+			(gps.sentenceHasFix ? GPSNMEA::Field_Location : 0);
+	}
+	// GGA と GNS は同じ項目
+	static uint16_t commitGGA(GPSNMEA &gps) {
+		gps.time.commit();
+		if (gps.sentenceHasFix)
+			gps.location.commit();
+		gps.satellites.commit();
+		gps.hdop.commit();
+		gps.altitude.commit();
+		return GPSNMEA::Field_Time | GPSNMEA::Field_Satellites | GPSNMEA::Field_Hdop | GPSNMEA::Field_Altitude |
+			(gps.sentenceHasFix ? GPSNMEA::Field_Location : 0);
+	}
+	static uint16_t commitGSA(GPSNMEA &gps) {
+		gps.gsa.talker = gps.curTalker;
+		gps.gsa.valid = true;
+		return GPSNMEA::Field_GSA;
+	}
+	static uint16_t commitGSV(GPSNMEA &gps) {
+		gps.gsv.talker = gps.curTalker;
+		gps.gsv.valid = true;
+		return GPSNMEA::Field_GSV | (gps.commitGSVPage() ? GPSNMEA::Field_SatelliteTable : 0);
+	}
+	static uint16_t commitVTG(GPSNMEA &gps) {
+		gps.vtg.valid = true;
+		return GPSNMEA::Field_VTG;
+	}
+	static uint16_t commitGLL(GPSNMEA &gps) {
+		gps.time.commit();
+		if (gps.sentenceHasFix)
+			gps.location.commit();
+		return GPSNMEA::Field_Time | (gps.sentenceHasFix ? GPSNMEA::Field_Location : 0);
+	}
+	static uint16_t commitZDA(GPSNMEA &gps) {
+		// 4桁の年があるので GPSNMEA_CENTURY_PIVOT によらず年が決まる
+		const int yy = gps.zda.year % 100;
+		gps.date.newDate = static_cast<uint32_t>((gps.zda.day * 100 + gps.zda.month) * 100 + (yy < 0 ? 0 : yy));
+		gps.date.newFullYear = static_cast<uint16_t>(gps.zda.year);
+		gps.date.commit();
+		gps.time.commit();
+		gps.dateMillisOfDay = gps.time.millisOfDay();
+		gps.zda.valid = true;
+		return GPSNMEA::Field_Date | GPSNMEA::Field_Time;
+	}
+	static uint16_t commitGST(GPSNMEA &gps) {
+		gps.gst.valid = true;
+		return GPSNMEA::Field_GST;
+	}
+	static uint16_t commitGBS(GPSNMEA &gps) {
+		gps.gbs.valid = true;
+		return GPSNMEA::Field_GBS;
+	}
+
+#if GPSNMEA_UBX
+	// UBX のペイロード (リトルエンディアン) の読み出し
+	static uint16_t ubxU2(const uint8_t *p) {
+		return static_cast<uint16_t>(p[0] | (p[1] << 8));
+	}
+	static uint32_t ubxU4(const uint8_t *p) {
+		return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+			(static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+	}
+	static int32_t ubxI4(const uint8_t *p) { return static_cast<int32_t>(ubxU4(p)); }
+	// v / d を四捨五入 (負の値は0から離れる向き)
+	static int32_t divRound(int32_t v, int32_t d) {
+		return v >= 0 ? (v + d / 2) / d : -((d / 2 - v) / d);
+	}
+
+	// UTC の時・分・秒とナノ秒 (-1e9 .. 1e9) -> hhmmsscc (1/100秒に四捨五入)
+	//  ナノ秒が負なら1秒前へ繰り下げる。閏秒(60秒)はそのまま通す
+	static uint32_t ubxTime(uint8_t h, uint8_t m, uint8_t s, int32_t nano) {
+		int32_t n = nano + 5000000;
+		int32_t cs = n >= 0 ? n / 10000000 : -((9999999 - n) / 10000000);
+		if (cs < 0) {
+			cs += 100;
+			if (s > 0) {
+				--s;
+			} else if (m > 0) {
+				--m;
+				s = 59;
+			} else if (h > 0) {
+				--h;
+				m = s = 59;
+			} else {
+				cs = 0;  // 前日になる分は0時で止める
+			}
+		}
+		if (cs > 99)
+			cs = 99;
+		return ((h * 100UL + m) * 100 + s) * 100 + static_cast<uint32_t>(cs);
+	}
+
+	// NAV-PVT: gnssFixOK が立ち、2D/3D (推測航法併用を含む) の測位か
+	static bool navPvtFix(const uint8_t *p) {
+		return (p[21] & 0x01) && p[20] >= 2 && p[20] <= 4;
+	}
+
+	// NAV-PVT: RMC と GGA を合わせた項目を1フレームでcommitする
+	//  hDOP は無いので hdop は更新しない (DOP は pvt.pdop)
+	static uint16_t commitNavPvt(GPSNMEA &gps) {
+		const uint8_t *p = gps.ubxPayload;
+		uint16_t fields = GPSNMEA::Field_Satellites | GPSNMEA::Field_Altitude | GPSNMEA::Field_Speed |
+			GPSNMEA::Field_Course | GPSNMEA::Field_PVT;
+		const uint8_t valid = p[11];
+		if (valid & 0x01) {
+			// validDate: 4桁の年があるので ZDA と同じく GPSNMEA_CENTURY_PIVOT によらない
+			const uint16_t year = ubxU2(p + 4);
+			gps.date.newDate = (p[7] * 100UL + p[6]) * 100 + year % 100;
+			gps.date.newFullYear = year;
+			gps.date.commit();
+			fields |= GPSNMEA::Field_Date;
+		}
+		if (valid & 0x02) {
+			// validTime
+			gps.time.newTime = ubxTime(p[8], p[9], p[10], ubxI4(p + 16));
+			gps.time.commit();
+			if (valid & 0x01)
+				gps.dateMillisOfDay = gps.time.millisOfDay();
+			fields |= GPSNMEA::Field_Time;
+		}
+		if (gps.sentenceHasFix) {
+			gpsDegreesFromE7(ubxI4(p + 28), gps.location.rawNewLatData);
+			gpsDegreesFromE7(ubxI4(p + 24), gps.location.rawNewLngData);
+			gps.location.commit();
+			fields |= GPSNMEA::Field_Location;
+		}
+		gps.satellites.newval = p[23];
+		gps.satellites.commit();
+		gps.altitude.newval = divRound(ubxI4(p + 36), 10);        // hMSL mm -> m x100
+		gps.altitude.commit();
+		const int32_t gSpeed = ubxI4(p + 60);                      // mm/s -> ノット x100 (x 3600/1852/10)
+		gps.speed.newval = gSpeed > 0 ? (gSpeed * 90 + 231) / 463 : 0;
+		gps.speed.commit();
+		gps.course.newval = divRound(ubxI4(p + 64), 1000);        // 1e-5度 -> 度 x100
+		gps.course.commit();
+
+		gps.pvt.iTOW = ubxU4(p);
+		gps.pvt.fixType = p[20];
+		gps.pvt.flags = p[21];
+		gps.pvt.height = ubxI4(p + 32);
+		gps.pvt.hAcc = ubxU4(p + 40);
+		gps.pvt.vAcc = ubxU4(p + 44);
+		gps.pvt.velN = ubxI4(p + 48);
+		gps.pvt.velE = ubxI4(p + 52);
+		gps.pvt.velD = ubxI4(p + 56);
+		gps.pvt.sAcc = ubxU4(p + 68);
+		gps.pvt.pdop = ubxU2(p + 76);
+		gps.pvt.valid = true;
+		return fields;
+	}
+
+	// NAV-SAT の衛星1件 (12バイト) を衛星テーブルの組み立て中サイクルへ
+	//  衛星番号は GSV と同じ NMEA の番号に揃える (SBAS 33-64, GLONASS 65-96)
+	static void stageNavSat(GPSNMEA &gps, const uint8_t *rec) {
+#if GPSNMEA_SATELLITE_TABLE
+		static const uint8_t talkers[8] = {
+			GPSNMEA::Talker_GP, GPSNMEA::Talker_GP, GPSNMEA::Talker_GA, GPSNMEA::Talker_GB,
+			GPSNMEA::Talker_Unknown, GPSNMEA::Talker_GQ, GPSNMEA::Talker_GL, GPSNMEA::Talker_GI
+		};
+		const uint8_t gnssId = rec[0];
+		if (gnssId >= 8)
+			return;
+		uint16_t prn = rec[1];
+		if (gnssId == 1 && prn >= 120)
+			prn -= 87;
+		else if (gnssId == 6 && prn <= 32)
+			prn += 64;
+		const int16_t azim = static_cast<int16_t>(ubxU2(rec + 4));
+
+		GPSSatellite sat;
+		sat.prn = prn;
+		sat.azimuth = static_cast<uint16_t>(azim < 0 ? 0 : azim);
+		sat.elevation = static_cast<int8_t>(rec[3]);
+		sat.snr = rec[2];
+		sat.talker = talkers[gnssId];
+		sat.signalId = 0;
+		gps.satelliteTable.stage(sat);
+#else
+		(void)gps;
+		(void)rec;
+#endif
+	}
+	// NAV-SAT: 長さが衛星数と合っていれば、全衛星系をまとめて衛星テーブルに公開
+	static uint16_t commitNavSat(GPSNMEA &gps) {
+		if (gps.ubxLength != 8 + 12 * gps.ubxPayload[5])
+			return 0;
+#if GPSNMEA_SATELLITE_TABLE
+		return gps.satelliteTable.publishAll() ? GPSNMEA::Field_SatelliteTable : 0;
+#else
+		return 0;
+#endif
+	}
+#endif
+};
+
+namespace {
+
+// AVR では表をフラッシュに置き、1要素ずつ読み出す (全種別で約400バイトのRAMを節約)
+#if defined(__AVR__)
+#define GPSNMEA_PROGMEM PROGMEM
+template <class T>
+inline T loadTable(const T &entry) {
+	T v;
+	memcpy_P(&v, &entry, sizeof(T));
+	return v;
 }
+#else
+#define GPSNMEA_PROGMEM
+template <class T>
+inline const T &loadTable(const T &entry) { return entry; }
+#endif
+
+struct TermRule {
+	void (*parse)(GPSNMEA &gps, const char *term, uint8_t arg);  // nullptr なら読み捨て
+	uint8_t arg;
+};
+
+struct SentenceSchema {
+	const TermRule *terms;  // terms[n] が term番号 n の規則 (terms[0] はアドレスなので未使用)
+	uint8_t termCount;
+	void (*begin)(GPSNMEA &gps);       // アドレスを判定した直後 (nullptr 可)
+	uint16_t (*commit)(GPSNMEA &gps);  // チェックサム一致時 (nullptr なら commit なし)
+};
+
+typedef GPSNMEAFields F;
+
+#define GPSNMEA_SKIP { nullptr, 0 }
+#define GPSNMEA_FIELD(fn) { &F::fn, 0 }
+// gsa, vtg などの構造体の型 (GPSNMEA_FIXED/GPSNMEA_NUMBER で group##Data として使う)
+typedef decltype(GPSNMEA::gsa) gsaData;
+typedef decltype(GPSNMEA::gsv) gsvData;
+typedef decltype(GPSNMEA::vtg) vtgData;
+typedef decltype(GPSNMEA::zda) zdaData;
+typedef decltype(GPSNMEA::gst) gstData;
+typedef decltype(GPSNMEA::gbs) gbsData;
+#define GPSNMEA_FIXED(group, member, digits) \
+	{ &F::fixed<group##Data, &GPSNMEA::group, decltype(group##Data::member), &group##Data::member>, digits }
+#define GPSNMEA_NUMBER(group, member) \
+	{ &F::number<group##Data, &GPSNMEA::group, decltype(group##Data::member), &group##Data::member>, 0 }
+
+// RMC: 時刻, 状態, 緯度, N/S, 経度, E/W, 速度(ノット), 針路, 日付, ...
+constexpr TermRule kRMC[] GPSNMEA_PROGMEM = {
+	GPSNMEA_SKIP,
+	GPSNMEA_FIELD(time), GPSNMEA_FIELD(status),
+	GPSNMEA_FIELD(latitude), GPSNMEA_FIELD(northSouth), GPSNMEA_FIELD(longitude), GPSNMEA_FIELD(eastWest),
+	{ &F::decimal<&GPSNMEA::speed>, 0 }, { &F::decimal<&GPSNMEA::course>, 0 },
+	GPSNMEA_FIELD(date),
+};
+
+// GGA: 時刻, 緯度, N/S, 経度, E/W, 品質, 衛星数, HDOP, 高度, ...
+//  GNS も同じ並びで、品質の代わりに衛星系ごとのモード文字列
+constexpr TermRule kGGA[] GPSNMEA_PROGMEM = {
+	GPSNMEA_SKIP,
+	GPSNMEA_FIELD(time),
+	GPSNMEA_FIELD(latitude), GPSNMEA_FIELD(northSouth), GPSNMEA_FIELD(longitude), GPSNMEA_FIELD(eastWest),
+	GPSNMEA_FIELD(quality),
+	{ &F::integer<&GPSNMEA::satellites>, 0 }, { &F::decimal<&GPSNMEA::hdop>, 0 }, { &F::decimal<&GPSNMEA::altitude>, 0 },
+};
+constexpr TermRule kGNS[] GPSNMEA_PROGMEM = {
+	GPSNMEA_SKIP,
+	GPSNMEA_FIELD(time),
+	GPSNMEA_FIELD(latitude), GPSNMEA_FIELD(northSouth), GPSNMEA_FIELD(longitude), GPSNMEA_FIELD(eastWest),
+	GPSNMEA_FIELD(gnsMode),
+	{ &F::integer<&GPSNMEA::satellites>, 0 }, { &F::decimal<&GPSNMEA::hdop>, 0 }, { &F::decimal<&GPSNMEA::altitude>, 0 },
+};
+
+// GSA: モード, 測位種別, PRN x12, PDOP, HDOP, VDOP
+constexpr TermRule kGSA[] GPSNMEA_PROGMEM = {
+	GPSNMEA_SKIP,
+	GPSNMEA_FIELD(gsaMode), GPSNMEA_NUMBER(gsa, fixType),
+	{ &F::gsaPrn, 0 }, { &F::gsaPrn, 1 }, { &F::gsaPrn, 2 }, { &F::gsaPrn, 3 },
+	{ &F::gsaPrn, 4 }, { &F::gsaPrn, 5 }, { &F::gsaPrn, 6 }, { &F::gsaPrn, 7 },
+	{ &F::gsaPrn, 8 }, { &F::gsaPrn, 9 }, { &F::gsaPrn, 10 }, { &F::gsaPrn, 11 },
+	GPSNMEA_FIXED(gsa, pdop, 2), GPSNMEA_FIXED(gsa, hdop, 2), GPSNMEA_FIXED(gsa, vdop, 2),
+};
+
+// GSV: ページ数, ページ番号, 衛星数, (PRN, 仰角, 方位角, SNR) x4, signal ID
+//  衛星が4未満のページの signal ID は衛星欄に入り、commitGSVPage() で取り出す
+#define GPSNMEA_GSV_SATELLITE(n) \
+	{ &F::gsvSatellite, 4 * (n) }, { &F::gsvSatellite, 4 * (n) + 1 }, \
+	{ &F::gsvSatellite, 4 * (n) + 2 }, { &F::gsvSatellite, 4 * (n) + 3 }
+constexpr TermRule kGSV[] GPSNMEA_PROGMEM = {
+	GPSNMEA_SKIP,
+	GPSNMEA_NUMBER(gsv, totalMessages), GPSNMEA_NUMBER(gsv, messageNumber), GPSNMEA_NUMBER(gsv, satellitesInView),
+	GPSNMEA_GSV_SATELLITE(0), GPSNMEA_GSV_SATELLITE(1), GPSNMEA_GSV_SATELLITE(2), GPSNMEA_GSV_SATELLITE(3),
+	GPSNMEA_NUMBER(gsv, signalId),
+};
+#undef GPSNMEA_GSV_SATELLITE
+
+// VTG: 真方位, T, 磁方位, M, 速度(ノット), N, 速度(km/h), K
+constexpr TermRule kVTG[] GPSNMEA_PROGMEM = {
+	GPSNMEA_SKIP,
+	GPSNMEA_FIXED(vtg, trueTrack, 2), GPSNMEA_SKIP,
+	GPSNMEA_FIXED(vtg, magneticTrack, 2), GPSNMEA_SKIP,
+	GPSNMEA_FIXED(vtg, speedKnots, 2), GPSNMEA_SKIP,
+	GPSNMEA_FIXED(vtg, speedKmph, 2),
+};
+
+// GLL: 緯度, N/S, 経度, E/W, 時刻, 状態, モード
+constexpr TermRule kGLL[] GPSNMEA_PROGMEM = {
+	GPSNMEA_SKIP,
+	GPSNMEA_FIELD(latitude), GPSNMEA_FIELD(northSouth), GPSNMEA_FIELD(longitude), GPSNMEA_FIELD(eastWest),
+	GPSNMEA_FIELD(time), GPSNMEA_FIELD(status), GPSNMEA_FIELD(modeIndicator),
+};
+
+// ZDA: 時刻, 日, 月, 年(4桁), 時間帯(時), 時間帯(分)
+constexpr TermRule kZDA[] GPSNMEA_PROGMEM = {
+	GPSNMEA_SKIP,
+	GPSNMEA_FIELD(time),
+	GPSNMEA_NUMBER(zda, day), GPSNMEA_NUMBER(zda, month), GPSNMEA_NUMBER(zda, year),
+	GPSNMEA_NUMBER(zda, zoneHours), GPSNMEA_NUMBER(zda, zoneMinutes),
+};
+
+// GST: 時刻, RMS, 長軸, 短軸, 向き, 緯度, 経度, 高度の標準偏差 (RTK でも桁が落ちないよう mm)
+constexpr TermRule kGST[] GPSNMEA_PROGMEM = {
+	GPSNMEA_SKIP,
+	GPSNMEA_FIXED(gst, time, 2),
+	GPSNMEA_FIXED(gst, rms, 3), GPSNMEA_FIXED(gst, sdMajor, 3), GPSNMEA_FIXED(gst, sdMinor, 3),
+	GPSNMEA_FIXED(gst, orientation, 2),
+	GPSNMEA_FIXED(gst, sdLat, 3), GPSNMEA_FIXED(gst, sdLng, 3), GPSNMEA_FIXED(gst, sdAlt, 3),
+};
+
+// GBS: 時刻, 緯度・経度・高度の誤差, 異常衛星ID, 見逃し確率, バイアス, その標準偏差
+constexpr TermRule kGBS[] GPSNMEA_PROGMEM = {
+	GPSNMEA_SKIP,
+	GPSNMEA_FIXED(gbs, time, 2),
+	GPSNMEA_FIXED(gbs, errLat, 2), GPSNMEA_FIXED(gbs, errLng, 2), GPSNMEA_FIXED(gbs, errAlt, 2),
+	GPSNMEA_NUMBER(gbs, failedSatellite), GPSNMEA_FIXED(gbs, probability, 4),
+	GPSNMEA_FIXED(gbs, bias, 2), GPSNMEA_FIXED(gbs, biasSd, 2),
+};
+
+#undef GPSNMEA_SKIP
+#undef GPSNMEA_FIELD
+#undef GPSNMEA_FIXED
+#undef GPSNMEA_NUMBER
+
+// 種別 -> スキーマ。GPSNMEA_SENTENCES に含まれない種別は空にする
+//  (表もパーサ関数も参照されなくなり、リンクされない)
+#define GPSNMEA_SCHEMA(bit, terms, begin, commit) \
+	((GPSNMEA_SENTENCES & (bit)) \
+		? SentenceSchema{ terms, sizeof(terms) / sizeof(terms[0]), begin, commit } \
+		: SentenceSchema{ nullptr, 0, nullptr, nullptr })
+// UBX はtermが無いので commit だけ (GPSNMEA_UBX が 0 なら空)
+#if GPSNMEA_UBX
+#define GPSNMEA_UBX_SCHEMA(bit, commit) \
+	((GPSNMEA_SENTENCES & (bit)) \
+		? SentenceSchema{ nullptr, 0, nullptr, commit } \
+		: SentenceSchema{ nullptr, 0, nullptr, nullptr })
+#else
+#define GPSNMEA_UBX_SCHEMA(bit, commit) SentenceSchema{ nullptr, 0, nullptr, nullptr }
+#endif
+constexpr SentenceSchema kSchemas[GPSNMEA::SentenceType_Count] GPSNMEA_PROGMEM = {
+	/* Other */ { nullptr, 0, nullptr, nullptr },
+	/* RMC */ GPSNMEA_SCHEMA(GPSNMEA_SENTENCE_RMC, kRMC, nullptr, &F::commitRMC),
+	/* GGA */ GPSNMEA_SCHEMA(GPSNMEA_SENTENCE_GGA, kGGA, nullptr, &F::commitGGA),
+	/* GSA */ GPSNMEA_SCHEMA(GPSNMEA_SENTENCE_GSA, kGSA, nullptr, &F::commitGSA),
+	/* GSV */ GPSNMEA_SCHEMA(GPSNMEA_SENTENCE_GSV, kGSV, &F::beginGSV, &F::commitGSV),
+	/* VTG */ GPSNMEA_SCHEMA(GPSNMEA_SENTENCE_VTG, kVTG, nullptr, &F::commitVTG),
+	/* GLL */ GPSNMEA_SCHEMA(GPSNMEA_SENTENCE_GLL, kGLL, nullptr, &F::commitGLL),
+	/* ZDA */ GPSNMEA_SCHEMA(GPSNMEA_SENTENCE_ZDA, kZDA, nullptr, &F::commitZDA),
+	/* GST */ GPSNMEA_SCHEMA(GPSNMEA_SENTENCE_GST, kGST, nullptr, &F::commitGST),
+	/* GNS */ GPSNMEA_SCHEMA(GPSNMEA_SENTENCE_GNS, kGNS, nullptr, &F::commitGGA),
+	/* GBS */ GPSNMEA_SCHEMA(GPSNMEA_SENTENCE_GBS, kGBS, nullptr, &F::commitGBS),
+	/* NAVPVT */ GPSNMEA_UBX_SCHEMA(GPSNMEA_SENTENCE_NAVPVT, &F::commitNavPvt),
+	/* NAVSAT */ GPSNMEA_UBX_SCHEMA(GPSNMEA_SENTENCE_NAVSAT, &F::commitNavSat),
+};
+#undef GPSNMEA_SCHEMA
+#undef GPSNMEA_UBX_SCHEMA
+
+static_assert(sizeof(kSchemas) / sizeof(kSchemas[0]) == GPSNMEA::SentenceType_Count,
+	"kSchemas: one entry per GPSNMEA::SentenceType");
+
+} // namespace
 
 //=================================================================
 // GPSNMEA クラス実装
@@ -62,6 +871,9 @@ GPSNMEA::GPSNMEA()
 	: parity(0),
 	isChecksumTerm(false),
 	curSentenceType(SentenceType_Other),
+	curTalker(Talker_Unknown),
+	committedMask(0),
+	dateMillisOfDay(0),
 	curTermNumber(0),
 	curTermOffset(0),
 	sentenceHasFix(false),
@@ -69,61 +881,262 @@ GPSNMEA::GPSNMEA()
 	sentencesWithFixCount(0),
 	failedChecksumCount(0),
 	passedChecksumCount(0),
-	customElts(nullptr),
-	customCandidates(nullptr)
+	skippedSentenceCount(0),
+#if GPSNMEA_RTCM
+	rtcmFrameCount(0),
+	rtcmFailedCount(0),
+#endif
+	subscribedMask(GPSNMEA_SENTENCES),
+	skipSentence(false),
+#if GPSNMEA_UBX
+	ubxState(Ubx_Idle),
+	ubxClass(0),
+	ubxId(0),
+	ubxLength(0),
+	ubxOffset(0),
+	ubxCkA(0),
+	ubxCkB(0),
+	ubxRecvA(0),
+	ubxType(SentenceType_Other),
+	ubxLastMessage(0),
+#endif
+#if GPSNMEA_RTCM
+	rtcmFill(0),
+#endif
+	customSentenceCount(0),
+	customSentence(nullptr),
+	customCursor(nullptr)
 {
-	memset(termBuffer, 0, MAX_TERM_LENGTH);
+	memset(termBuffer, 0, TERM_BUFFER_LENGTH);
+	termLimit = MAX_TERM_LENGTH - 1;
+	memset(customTable, 0, sizeof(customTable));
+	clearCallbacks();
+#if GPSNMEA_INSTRUMENTATION
+	resetStats();
+#endif
 
 	// GSA初期化
+	gsa.talker = Talker_Unknown;
 	gsa.mode = '\0';
 	gsa.fixType = 0;
 	memset(gsa.satPrn, 0, sizeof(gsa.satPrn));
-	gsa.pdop = gsa.hdop = gsa.vdop = 0.0;
+	gsa.pdop = gsa.hdop = gsa.vdop = 0;
 	gsa.valid = false;
 
 	// GSV初期化
+	gsv.talker = Talker_Unknown;
 	gsv.totalMessages = 0;
 	gsv.messageNumber = 0;
 	gsv.satellitesInView = 0;
 	memset(gsv.satellites, 0, sizeof(gsv.satellites));
+	gsv.signalId = 0;
 	gsv.valid = false;
 
 	// VTG初期化
-	vtg.trueTrack = 0.0;
-	vtg.magneticTrack = 0.0;
-	vtg.speedKnots = 0.0;
-	vtg.speedKmph = 0.0;
+	vtg.trueTrack = 0;
+	vtg.magneticTrack = 0;
+	vtg.speedKnots = 0;
+	vtg.speedKmph = 0;
 	vtg.valid = false;
+
+	// ZDA, GST, GBS初期化
+	memset(&zda, 0, sizeof(zda));
+	memset(&gst, 0, sizeof(gst));
+	memset(&gbs, 0, sizeof(gbs));
+#if GPSNMEA_UBX
+	memset(&pvt, 0, sizeof(pvt));
+	memset(ubxPayload, 0, sizeof(ubxPayload));
+#endif
 }
 
 void GPSNMEA::reset() {
 	parity = 0;
 	isChecksumTerm = false;
 	curSentenceType = SentenceType_Other;
+	curTalker = Talker_Unknown;
+	committedMask = 0;
+	dateMillisOfDay = 0;
 	curTermNumber = 0;
 	curTermOffset = 0;
 	sentenceHasFix = false;
-	memset(termBuffer, 0, MAX_TERM_LENGTH);
+	memset(termBuffer, 0, TERM_BUFFER_LENGTH);
+	termLimit = MAX_TERM_LENGTH - 1;
 
 	// 統計
 	encodedCharCount = 0;
 	sentencesWithFixCount = 0;
 	failedChecksumCount = 0;
 	passedChecksumCount = 0;
+	skippedSentenceCount = 0;
+	skipSentence = false;
 
-	// カスタムフィールド
-	customElts = nullptr;
-	customCandidates = nullptr;
+	// カスタムフィールドとコールバック
+	clearCustom();
+	clearCallbacks();
 
-	// GSA, GSV, VTGリセット
+	// GSA, GSV, VTG, ZDA, GST, GBSリセット
 	gsa.valid = false;
 	gsv.valid = false;
 	vtg.valid = false;
+	zda.valid = false;
+	gst.valid = false;
+	gbs.valid = false;
+#if GPSNMEA_SATELLITE_TABLE
+	satelliteTable.clear();
+#endif
+#if GPSNMEA_UBX
+	pvt.valid = false;
+	ubxState = Ubx_Idle;
+	ubxLastMessage = 0;
+#endif
+#if GPSNMEA_RTCM
+	rtcmFill = 0;
+	rtcmFrameCount = 0;
+	rtcmFailedCount = 0;
+#endif
+
+#if GPSNMEA_INSTRUMENTATION
+	resetStats();
+#endif
 }
 
 bool GPSNMEA::encode(char c) {
 	++encodedCharCount;
+#if GPSNMEA_UBX
+	if (ubxState != Ubx_Idle) {
+		bool frame = false;
+		uint8_t b = static_cast<uint8_t>(c);
+		if (ubxBytes(&b, 1, frame) != 0)
+			return frame;
+		// 同期違い: このバイトは NMEA の文字として処理する
+	}
+#endif
+#if GPSNMEA_RTCM
+	if (rtcmFill != 0) {
+		uint8_t b = static_cast<uint8_t>(c);
+		if (rtcmBytes(&b, 1) != 0)
+			return false;
+	}
+#endif
+
+	switch(c) {
+		case ',':
+		case '\r':
+		case '\n':
+		case '*':
+		case '$':
+			return processDelimiter(c);
+#if GPSNMEA_UBX
+		case kUbxSync1:
+			ubxState = Ubx_Sync;
+			return false;
+#endif
+#if GPSNMEA_RTCM
+		case kRtcmPreamble:
+			rtcmBuffer[0] = 0xD3;
+			rtcmFill = 1;
+			return false;
+#endif
+		default:
+#if GPSNMEA_INSTRUMENTATION
+			statBytes(1);
+#endif
+			if (!isChecksumTerm) {
+				parity ^= (uint8_t)c;
+				if (skipSentence)
+					return false;
+			}
+			if (curTermOffset < termLimit) {
+				termBuffer[curTermOffset++] = c;
+			}
+#if GPSNMEA_INSTRUMENTATION
+			else {
+				termTruncated = true;
+			}
+#endif
+			return false;
+	}
+}
+
+size_t GPSNMEA::encode(const char *buf, size_t len) {
+	size_t completed = 0;
+	const char *p = buf;
+	const char *end = buf + len;
+	encodedCharCount += len;
+#if GPSNMEA_INSTRUMENTATION
+	// この呼び出しの中で費やした時間だけをセンテンスに割り当てる
+	timing = true;
+	timeMark = gpsStatTicks();
+#endif
+
+	while (p < end) {
+#if GPSNMEA_UBX
+		if (ubxState != Ubx_Idle) {
+			// UBXフレームの途中 (ペイロードはまとめてチェックサム計算とコピー)
+			bool frame = false;
+			p += ubxBytes(reinterpret_cast<const uint8_t *>(p), end - p, frame);
+			if (frame)
+				++completed;
+			continue;
+		}
+#endif
+#if GPSNMEA_RTCM
+		if (rtcmFill != 0) {
+			// 前の呼び出しから続く RTCM3 フレーム
+			p += rtcmBytes(reinterpret_cast<const uint8_t *>(p), end - p);
+			continue;
+		}
+#endif
+		// 区切り文字までをtermとして一括処理
+		const char *d = gpsScanDelimiter<GPSNMEA_UBX != 0, GPSNMEA_RTCM != 0>(p, end);
+		if (d != p)
+			appendTerm(p, d - p);
+		if (d == end)
+			break;
+#if GPSNMEA_UBX
+		if (*d == kUbxSync1) {
+			ubxState = Ubx_Sync;
+			p = d + 1;
+			continue;
+		}
+#endif
+#if GPSNMEA_RTCM
+		if (*d == kRtcmPreamble) {
+			p = d + rtcmStart(reinterpret_cast<const uint8_t *>(d), end - d);
+			continue;
+		}
+#endif
+		if (processDelimiter(*d))
+			++completed;
+		p = d + 1;
+	}
+#if GPSNMEA_INSTRUMENTATION
+	sentenceTicks += gpsStatTicks() - timeMark;
+	timing = false;
+#endif
+	return completed;
+}
 
+void GPSNMEA::appendTerm(const char *p, size_t len) {
+#if GPSNMEA_INSTRUMENTATION
+	statBytes(len);
+#endif
+	if (!isChecksumTerm) {
+		parity ^= gpsXorBytes(p, len);
+		if (skipSentence)
+			return;
+	}
+	size_t room = termLimit - curTermOffset;
+	size_t n = (len < room) ? len : room;
+	memcpy(termBuffer + curTermOffset, p, n);
+	curTermOffset += n;
+#if GPSNMEA_INSTRUMENTATION
+	if (n < len)
+		termTruncated = true;
+#endif
+}
+
+bool GPSNMEA::processDelimiter(char c) {
 	switch(c) {
 		case ',':
 			if (!isChecksumTerm)
@@ -132,36 +1145,63 @@ bool GPSNMEA::encode(char c) {
 		case '\r':
 		case '\n':
 		case '*': {
-			if (curTermOffset < MAX_TERM_LENGTH)
-				termBuffer[curTermOffset] = '\0';
+#if GPSNMEA_INSTRUMENTATION
+			if (c == ',' || c == '*')
+				statBytes(1);
+			else
+				inSentence = false;  // 行末 (チェックサムまで来ていなければ捨てられる。garbage には数えない)
+#endif
+			if (skipSentence && !isChecksumTerm) {
+				// 読み飛ばし中はtermを処理せず、'*' 以降のチェックサムだけを見る
+				isChecksumTerm = (c == '*');
+				return false;
+			}
+			termBuffer[curTermOffset] = '\0';
+#if GPSNMEA_INSTRUMENTATION
+			if (termTruncated) {
+				statsData.truncatedTerms++;
+				termTruncated = false;
+			}
+#endif
 			bool validSentence = endOfTermHandler();
 			curTermNumber++;
 			curTermOffset = 0;
 			isChecksumTerm = (c == '*');
 			return validSentence;
 		}
-		case '$': {
-			// 文頭初期化
-			curTermNumber = 0;
-			curTermOffset = 0;
-			parity = 0;
-			curSentenceType = SentenceType_Other;
-			isChecksumTerm = false;
-			sentenceHasFix = false;
-			memset(termBuffer, 0, MAX_TERM_LENGTH);
-			return false;
-		}
+		case '$':
 		default:
-			if (curTermOffset < (MAX_TERM_LENGTH - 1)) {
-				termBuffer[curTermOffset++] = c;
-			}
-			if (!isChecksumTerm) {
-				parity ^= (uint8_t)c;
-			}
+#if GPSNMEA_INSTRUMENTATION
+			if (inSentence)
+				statsData.resyncs++;
+			inSentence = true;
+			sentenceLength = 1;
+			sentenceTicks = 0;  // 直前のセンテンス(か呼び出しの入口)からの時間を数える
+#endif
+			beginSentence();
 			return false;
 	}
 }
 
+void GPSNMEA::beginSentence() {
+	// 文頭初期化
+	curTermNumber = 0;
+	curTermOffset = 0;
+	parity = 0;
+	curSentenceType = SentenceType_Other;
+	curTalker = Talker_Unknown;
+	isChecksumTerm = false;
+	sentenceHasFix = false;
+	skipSentence = false;
+	customSentence = nullptr;
+	customCursor = nullptr;
+	memset(termBuffer, 0, TERM_BUFFER_LENGTH);
+	termLimit = MAX_TERM_LENGTH - 1;
+#if GPSNMEA_INSTRUMENTATION
+	termTruncated = false;
+#endif
+}
+
 int GPSNMEA::fromHex(char a) {
 	return gpsFromHex(a);
 }
@@ -170,253 +1210,575 @@ bool GPSNMEA::endOfTermHandler() {
 	if (isChecksumTerm) {
 		// チェックサム部を処理
 		uint8_t chksum = (uint8_t)(16 * fromHex(termBuffer[0]) + fromHex(termBuffer[1]));
-		if (chksum == parity) {
-			passedChecksumCount++;
-			if (sentenceHasFix)
-				sentencesWithFixCount++;
-
-			// センテンス種類ごとのcommit
-			switch(curSentenceType) {
-				case SentenceType_RMC:
-					date.commit();
-					time.commit();
-					if (sentenceHasFix)
-						location.commit();
-					speed.commit();
-					course.commit();
-					break;
-				case SentenceType_GGA:
-					time.commit();
-					if (sentenceHasFix)
-						location.commit();
-					satellites.commit();
-					hdop.commit();
-					altitude.commit();
-					break;
-				case SentenceType_GSA:
-					gsa.valid = true;
-					break;
-				case SentenceType_GSV:
-					gsv.valid = true;
-					break;
-				case SentenceType_VTG:
-					vtg.valid = true;
-					break;
-				default:
-					break;
-			}
-
-			// カスタムフィールドをcommit
-			for (GPSCustom *p = customCandidates; p != nullptr &&
-			strcmp(p->sentenceName, customCandidates->sentenceName) == 0;
-			p = p->next)
-			{
-				p->commit();
-			}
-			return true;
-		} else {
-			failedChecksumCount++;
-			return false;
-		}
+		return finishSentence(chksum, parity);
 	}
+	handleTerm(termBuffer, curTermOffset);
+	return false;
+}
 
-	// センテンス名（termNumber=0）を解析
-	if (curTermNumber == 0) {
-		// 例: "GPRMC", "GPGGA", "GPGSA" など
-		if ((termBuffer[0] == 'G' || termBuffer[0] == 'N') &&
-			(termBuffer[1] == 'P' || termBuffer[1] == 'N'))
-		{
-			if (strcmp(termBuffer + 2, "RMC") == 0)
-				curSentenceType = SentenceType_RMC;
-			else if (strcmp(termBuffer + 2, "GGA") == 0)
-				curSentenceType = SentenceType_GGA;
-			else if (strcmp(termBuffer + 2, "GSA") == 0)
-				curSentenceType = SentenceType_GSA;
-			else if (strcmp(termBuffer + 2, "GSV") == 0)
-				curSentenceType = SentenceType_GSV;
-			else if (strcmp(termBuffer + 2, "VTG") == 0)
-				curSentenceType = SentenceType_VTG;
-			else
-				curSentenceType = SentenceType_Other;
-		}
+bool GPSNMEA::decode(const GPSSentenceView &sentence) {
+	encodedCharCount += sentence.length();
+	beginSentence();
+#if GPSNMEA_INSTRUMENTATION
+	timing = true;
+	timeMark = gpsStatTicks();
+	sentenceTicks = 0;
+	inSentence = true;
+	sentenceLength = (uint16_t)((sentence.length() < 0xFFFF) ? sentence.length() : 0xFFFF);
+#endif
 
-		// カスタム候補のリスト頭出し
-		for (customCandidates = customElts; customCandidates != nullptr &&
-		strcmp(customCandidates->sentenceName, termBuffer) < 0;
-		customCandidates = customCandidates->next)
-		{
-			/* no-op */
-		}
-		if (customCandidates != nullptr &&
-			strcmp(customCandidates->sentenceName, termBuffer) > 0)
-		{
-			customCandidates = nullptr;
-		}
+	// termBufferへコピーせず、ビュー上のtermを直接パーサへ渡す
+	GPSTermView term = { nullptr, 0 };
+	while (sentence.nextTerm(term)) {
+#if GPSNMEA_INSTRUMENTATION
+		// encode() と同じ長さを超えるtermを数える
+		if (term.length > termLimit)
+			statsData.truncatedTerms++;
+#endif
+		handleTerm(term.data, term.length);
+		curTermNumber++;
+		if (skipSentence)
+			break;  // 購読対象外
+	}
+	bool valid = false;
+	if (sentence.hasChecksum()) {
+		parity = sentence.computeChecksum();
+		valid = finishSentence(sentence.checksum(), parity);
+	}
+#if GPSNMEA_INSTRUMENTATION
+	inSentence = false;
+	timing = false;
+#endif
+	return valid;
+}
+
+// センテンス名 name と term (長さ len、NUL終端とは限らない) を strcmp と同じ向きで比較
+static int compareSentenceName(const char *name, const char *term, size_t len) {
+	int cmp = strncmp(name, term, len);
+	if (cmp != 0)
+		return cmp;
+	return (name[len] == '\0') ? 0 : 1;
+}
 
+bool GPSNMEA::finishSentence(uint8_t chksum, uint8_t computed) {
+	if (chksum != computed) {
+		failedChecksumCount++;
+#if GPSNMEA_INSTRUMENTATION
+		statSentence(false);
+#endif
+		if (checksumCallback != nullptr)
+			checksumCallback(*this, chksum, computed, checksumContext);
 		return false;
 	}
 
-	// 本文のパース
-	if (curSentenceType != SentenceType_Other && termBuffer[0] != '\0') {
-		switch(curSentenceType) {
-			case SentenceType_RMC:
-				parseRMCTerm(curTermNumber, termBuffer, *this);
+	passedChecksumCount++;
+	committedMask = 0;
+	if (!(subscribedMask & sentenceBit(curSentenceType))) {
+		// 購読対象外: チェックサムの集計(と登録済みカスタムフィールド)のみ
+		skippedSentenceCount++;
+	} else {
+		if (sentenceHasFix)
+			sentencesWithFixCount++;
+		commitSentence();
+		if (committedMask != 0)
+			publishSnapshot();
+	}
+
+	// カスタムフィールドをcommit
+	if (customSentence != nullptr) {
+		for (GPSCustom *p = customSentence->head; p != nullptr; p = p->next)
+			p->commit();
+	}
+#if GPSNMEA_INSTRUMENTATION
+	statSentence(true);  // コールバックの実行時間は含めない
+#endif
+
+	dispatchCallbacks();
+	return true;
+}
+
+void GPSNMEA::dispatchCallbacks() {
+	const SentenceHandler &h = sentenceHandlers[curSentenceType];
+	if (h.callback != nullptr)
+		h.callback(*this, h.context);
+
+	if (committedMask == 0)
+		return;
+	for (uint8_t i = 0; i < commitHandlerCount; ++i) {
+		const CommitHandler &c = commitHandlers[i];
+		uint16_t fields = c.fields & committedMask;
+		if (fields != 0)
+			c.callback(*this, fields, c.context);
+	}
+}
+
+#if GPSNMEA_INSTRUMENTATION
+//-----------------------------------
+// 計測
+//-----------------------------------
+void GPSNMEA::statSentence(bool passed) {
+	inSentence = false;
+	if (passed) {
+		statsData.sentences[curSentenceType]++;
+		statsData.talkers[curTalker]++;
+	} else {
+		statsData.checksumErrors[curSentenceType]++;
+	}
+	// sentenceLength は CR/LF を含まない
+	if (sentenceLength + 2 > GPSNMEA_MAX_SENTENCE_LENGTH)
+		statsData.oversizedSentences++;
+
+	if (!timing)
+		return;
+	uint32_t now = gpsStatTicks();
+	uint32_t elapsed = sentenceTicks + (now - timeMark);
+	timeMark = now;
+	sentenceTicks = 0;
+
+	uint8_t bucket = 0;
+	for (uint32_t v = elapsed >> 1; v != 0 && bucket < GPSNMEA_STATS_BUCKETS - 1; v >>= 1)
+		bucket++;
+	statsData.parseHistogram[curSentenceType][bucket]++;
+	statsData.timedSentences[curSentenceType]++;
+	statsData.parseTicks[curSentenceType] += elapsed;
+}
+
+void GPSNMEA::resetStats() {
+	memset(&statsData, 0, sizeof(statsData));
+	inSentence = false;
+	termTruncated = false;
+	sentenceLength = 0;
+	timeMark = 0;
+	sentenceTicks = 0;
+	timing = false;
+}
+
+static const char *const statSentenceNames[GPSNMEA::SentenceType_Count] = {
+	"Other", "RMC", "GGA", "GSA", "GSV", "VTG", "GLL", "ZDA", "GST", "GNS", "GBS", "NAV-PVT", "NAV-SAT"
+};
+static const char *const statTalkerNames[GPSNMEA::Talker_Count] = {
+	"Unknown", "GP", "GL", "GA", "GB", "BD", "GQ", "QZ", "GI", "GN"
+};
+
+// snprintf の結果を連結する (buf が足りなくても必要な長さは数え続ける)
+static void appendFormat(char *buf, size_t size, size_t &pos, const char *fmt, ...) {
+	va_list ap;
+	va_start(ap, fmt);
+	int n = vsnprintf(buf + (pos < size ? pos : size), pos < size ? size - pos : 0, fmt, ap);
+	va_end(ap);
+	if (n > 0)
+		pos += n;
+}
+
+size_t GPSNMEA::formatStats(const Stats &stats, char *buf, size_t size) {
+	// {"sentences":{"RMC":{"passed":..,"failed":..,"ticks":..,"histogram":[..]},..},
+	//  "talkers":{"GP":..,..},"truncatedTerms":..,"oversizedSentences":..,"resyncs":..,"garbageBytes":..}
+	//  0件の種別・トーカーは省く。ticks は計測したセンテンスの合計
+	size_t pos = 0;
+	if (size != 0)
+		buf[0] = '\0';
+	appendFormat(buf, size, pos, "{\"sentences\":{");
+	bool first = true;
+	for (int t = 0; t < SentenceType_Count; ++t) {
+		if (stats.sentences[t] == 0 && stats.checksumErrors[t] == 0)
+			continue;
+		// 64bitの合計は printf の %llu が無い環境(avr-libc)もあるので自前で10進にする
+		char ticks[21];
+		char *q = ticks + sizeof(ticks) - 1;
+		*q = '\0';
+		uint64_t v = stats.parseTicks[t];
+		do {
+			*--q = (char)('0' + v % 10);
+			v /= 10;
+		} while (v != 0);
+		appendFormat(buf, size, pos, "%s\"%s\":{\"passed\":%lu,\"failed\":%lu,\"timed\":%lu,\"ticks\":%s,\"histogram\":[",
+			first ? "" : ",", statSentenceNames[t],
+			(unsigned long)stats.sentences[t], (unsigned long)stats.checksumErrors[t],
+			(unsigned long)stats.timedSentences[t], q);
+		for (int b = 0; b < GPSNMEA_STATS_BUCKETS; ++b)
+			appendFormat(buf, size, pos, b == 0 ? "%lu" : ",%lu", (unsigned long)stats.parseHistogram[t][b]);
+		appendFormat(buf, size, pos, "]}");
+		first = false;
+	}
+	appendFormat(buf, size, pos, "},\"talkers\":{");
+	first = true;
+	for (int t = 0; t < Talker_Count; ++t) {
+		if (stats.talkers[t] == 0)
+			continue;
+		appendFormat(buf, size, pos, "%s\"%s\":%lu", first ? "" : ",", statTalkerNames[t], (unsigned long)stats.talkers[t]);
+		first = false;
+	}
+	appendFormat(buf, size, pos, "},\"truncatedTerms\":%lu,\"oversizedSentences\":%lu,\"resyncs\":%lu,\"garbageBytes\":%lu}",
+		(unsigned long)stats.truncatedTerms, (unsigned long)stats.oversizedSentences,
+		(unsigned long)stats.resyncs, (unsigned long)stats.garbageBytes);
+	return pos;
+}
+#endif
+
+#if GPSNMEA_UBX
+//-----------------------------------
+// UBXフレーム
+//  0xB5 0x62, クラス, ID, 長さ(2), ペイロード, ck_a, ck_b
+//  NAV-PVT はペイロードを ubxPayload に溜め、NAV-SAT は衛星1件ごとに衛星テーブルへ渡す。
+//  チェックサムが一致したら NMEA のセンテンスと同じく finishSentence() で集計・commitする
+//-----------------------------------
+size_t GPSNMEA::ubxBytes(const uint8_t *p, size_t len, bool &frame) {
+	const uint8_t *start = p;
+	const uint8_t *end = p + len;
+	while (p < end) {
+		const uint8_t c = *p;
+		switch (ubxState) {
+			case Ubx_Sync:
+				if (c == 0x62) {
+					ubxState = Ubx_Class;
+					break;
+				}
+				if (c == 0xB5)
+					break;  // 0xB5 が続いた。次のバイトで同期を待つ
+				ubxState = Ubx_Idle;
+				return p - start;
+			case Ubx_Class:
+				ubxClass = c;
+				ubxCkA = ubxCkB = 0;
+				gpsUbxChecksum(p, 1, ubxCkA, ubxCkB);
+				ubxState = Ubx_Id;
 				break;
-			case SentenceType_GGA:
-				parseGGATerm(curTermNumber, termBuffer, *this);
+			case Ubx_Id:
+				ubxId = c;
+				gpsUbxChecksum(p, 1, ubxCkA, ubxCkB);
+				ubxState = Ubx_Length1;
 				break;
-			case SentenceType_GSA:
-				parseGSATerm(curTermNumber, termBuffer, *this);
+			case Ubx_Length1:
+				ubxLength = c;
+				gpsUbxChecksum(p, 1, ubxCkA, ubxCkB);
+				ubxState = Ubx_Length2;
 				break;
-			case SentenceType_GSV:
-				parseGSVTerm(curTermNumber, termBuffer, *this);
+			case Ubx_Length2: {
+				ubxLength = static_cast<uint16_t>(ubxLength | (c << 8));
+				gpsUbxChecksum(p, 1, ubxCkA, ubxCkB);
+				if (ubxLength > GPSNMEA_UBX_MAX_LENGTH) {
+					// 同期違い (0xB5 0x62 がたまたま並んだ) とみなして NMEA へ戻る
+					ubxState = Ubx_Idle;
+					return p + 1 - start;
+				}
+				// 長さの合わないものは種別を判定しない (NAV-PVT は古い版の84バイト以上)
+				const uint16_t message = static_cast<uint16_t>((ubxClass << 8) | ubxId);
+				ubxType = (message == 0x0107 && ubxLength >= UBX_BUFFER) ? SentenceType_NAVPVT :
+					(message == 0x0135 && ubxLength >= 8) ? SentenceType_NAVSAT : SentenceType_Other;
+#if GPSNMEA_SATELLITE_TABLE
+				if (ubxType == SentenceType_NAVSAT && (subscribedMask & sentenceBit(ubxType)))
+					satelliteTable.beginAll();
+#endif
+				ubxOffset = 0;
+				ubxState = (ubxLength != 0) ? Ubx_Payload : Ubx_CkA;
 				break;
-			case SentenceType_VTG:
-				parseVTGTerm(curTermNumber, termBuffer, *this);
+			}
+			case Ubx_Payload: {
+				size_t n = ubxLength - ubxOffset;
+				if (n > static_cast<size_t>(end - p))
+					n = end - p;
+				gpsUbxChecksum(p, n, ubxCkA, ubxCkB);
+				if (ubxType != SentenceType_Other && (subscribedMask & sentenceBit(ubxType)))
+					ubxPayloadBytes(p, n);
+				ubxOffset = static_cast<uint16_t>(ubxOffset + n);
+				if (ubxOffset == ubxLength)
+					ubxState = Ubx_CkA;
+				p += n;
+				continue;
+			}
+			case Ubx_CkA:
+				ubxRecvA = c;
+				ubxState = Ubx_CkB;
 				break;
+			case Ubx_CkB:
 			default:
-				break;
+				ubxState = Ubx_Idle;
+				frame = ubxFinish(c);
+				return p + 1 - start;
 		}
+		++p;
 	}
+	return len;
+}
 
-	// カスタムフィールドの更新
-	for (GPSCustom *p = customCandidates; 
-	p != nullptr && strcmp(p->sentenceName, customCandidates->sentenceName) == 0
-	&& p->termNumber <= curTermNumber;
-	p = p->next)
-	{
-		if (p->termNumber == curTermNumber) {
-			p->set(termBuffer);
+void GPSNMEA::ubxPayloadBytes(const uint8_t *p, size_t n) {
+	if ((GPSNMEA_SENTENCES & GPSNMEA_SENTENCE_NAVSAT) && ubxType == SentenceType_NAVSAT) {
+		// 先頭8バイトの後は衛星1件(12バイト)ずつ。揃うたびに衛星テーブルへ渡す
+		for (size_t i = 0; i < n; ++i) {
+			const size_t off = ubxOffset + i;
+			if (off < 8) {
+				ubxPayload[off] = p[i];
+				continue;
+			}
+			const size_t k = (off - 8) % 12;
+			ubxPayload[8 + k] = p[i];
+			if (k == 11)
+				GPSNMEAFields::stageNavSat(*this, ubxPayload + 8);
 		}
+	} else if (ubxOffset < UBX_BUFFER) {
+		size_t room = UBX_BUFFER - ubxOffset;
+		memcpy(ubxPayload + ubxOffset, p, n < room ? n : room);
 	}
-	return false;
 }
 
-// ---------------------------
-// private static parse関数群
-// ---------------------------
-void GPSNMEA::parseRMCTerm(int termNumber, const char *term, GPSNMEA &gps) {
-	switch(termNumber) {
-		case 1:
-			gps.time.setTime(term);
-			break;
-		case 2:
-			gps.sentenceHasFix = (term[0] == 'A');
-			break;
-		case 3:
-			gps.location.setLatitude(term);
-			break;
-		case 4:
-			gps.location.rawNewLatData.negative = (term[0] == 'S');
-			break;
-		case 5:
-			gps.location.setLongitude(term);
-			break;
-		case 6:
-			gps.location.rawNewLngData.negative = (term[0] == 'W');
-			break;
-		case 7:
-			gps.speed.set(term);
-			break;
-		case 8:
-			gps.course.set(term);
-			break;
-		case 9:
-			gps.date.setDate(term);
-			break;
-		default:
-			break;
+bool GPSNMEA::ubxFinish(uint8_t ckB) {
+	// NMEA のセンテンスと同じく、種別・測位の有無を決めてから finishSentence() へ
+	curSentenceType = ubxType;
+	curTalker = Talker_Unknown;
+	customSentence = nullptr;
+	sentenceHasFix = ubxType == SentenceType_NAVPVT && (subscribedMask & sentenceBit(ubxType)) &&
+		GPSNMEAFields::navPvtFix(ubxPayload);
+#if GPSNMEA_INSTRUMENTATION
+	sentenceLength = 0;  // NMEA のセンテンス長の上限とは比べない
+#endif
+	if (ubxRecvA != ubxCkA)
+		return finishSentence(ubxRecvA, ubxCkA);
+	if (ckB == ubxCkB)
+		ubxLastMessage = static_cast<uint16_t>((ubxClass << 8) | ubxId);
+	return finishSentence(ckB, ubxCkB);
+}
+#endif
+
+#if GPSNMEA_RTCM
+//-----------------------------------
+// RTCM3 フレーム
+//  0xD3, 予約6bit + 長さ10bit, ペイロード, CRC-24Q (3バイト)
+//  NMEA のセンテンスとは別に数え、commit もしない。コールバックへ渡すだけ
+//-----------------------------------
+size_t GPSNMEA::rtcmStart(const uint8_t *p, size_t len) {
+	if (len >= 3) {
+		const int n = gpsRtcmLength(p);
+		if (n < 0)
+			return 1;  // 予約bitが0でない: 同期違いとみなし 0xD3 だけ読み捨てる
+		const size_t total = static_cast<size_t>(n) + 6;
+		if (len >= total) {
+			// フレーム全体が受信バッファにある: コピーせずに渡す
+			//  CRC が合わなくても rtcmBytes() と同じくフレーム全体を読み捨てる
+			//  (encode(char) と結果を揃えるため。区切り方で数が変わらない)
+			rtcmDeliver(p);
+			return total;
+		}
 	}
+	// 呼び出しをまたぐフレームは内部バッファで組み立てる
+	rtcmFill = 0;
+	return rtcmBytes(p, len);
 }
 
-void GPSNMEA::parseGGATerm(int termNumber, const char *term, GPSNMEA &gps) {
-	switch(termNumber) {
-		case 1:
-			gps.time.setTime(term);
-			break;
-		case 2:
-			gps.location.setLatitude(term);
-			break;
-		case 3:
-			gps.location.rawNewLatData.negative = (term[0] == 'S');
-			break;
-		case 4:
-			gps.location.setLongitude(term);
-			break;
-		case 5:
-			gps.location.rawNewLngData.negative = (term[0] == 'W');
-			break;
-		case 6:
-			gps.sentenceHasFix = (term[0] > '0');
-			break;
-		case 7:
-			gps.satellites.set(term);
-			break;
-		case 8:
-			gps.hdop.set(term);
-			break;
-		case 9:
-			gps.altitude.set(term);
-			break;
-		default:
-			break;
+size_t GPSNMEA::rtcmBytes(const uint8_t *p, size_t len) {
+	size_t used = 0;
+	// ヘッダ (長さ) が揃うまでは1バイトずつ
+	while (rtcmFill < 3) {
+		if (used == len)
+			return used;
+		rtcmBuffer[rtcmFill++] = p[used++];
+		if (rtcmFill == 2 && (rtcmBuffer[1] & 0xFC) != 0) {
+			// 予約bitが0でない: 同期違い。このバイトは NMEA として処理する
+			rtcmFill = 0;
+			return used - 1;
+		}
+	}
+	const size_t total = static_cast<size_t>(gpsRtcmLength(rtcmBuffer)) + 6;
+	size_t n = total - rtcmFill;
+	if (n > len - used)
+		n = len - used;
+	memcpy(rtcmBuffer + rtcmFill, p + used, n);
+	rtcmFill = static_cast<uint16_t>(rtcmFill + n);
+	used += n;
+	if (rtcmFill == total) {
+		rtcmFill = 0;
+		rtcmDeliver(rtcmBuffer);
 	}
+	return used;
 }
 
-void GPSNMEA::parseGSATerm(int termNumber, const char *term, GPSNMEA &gps) {
-	if (termNumber == 1) {
-		if (term[0] != '\0') {
-			gps.gsa.mode = term[0];
+bool GPSNMEA::rtcmDeliver(const uint8_t *frame) {
+	GPSRtcmFrame view;
+	if (!gpsRtcmCheck(frame, view)) {
+		rtcmFailedCount++;
+		return false;
+	}
+	rtcmFrameCount++;
+	if (rtcmCallback != nullptr)
+		rtcmCallback(*this, view, rtcmContext);
+	return true;
+}
+#endif
+
+//-----------------------------------
+// コールバック登録
+//-----------------------------------
+void GPSNMEA::onSentence(SentenceType type, SentenceCallback callback, void *context) {
+	if (static_cast<unsigned>(type) >= SentenceType_Count)
+		return;
+	sentenceHandlers[type].callback = callback;
+	sentenceHandlers[type].context = context;
+}
+
+void GPSNMEA::onChecksumError(ChecksumCallback callback, void *context) {
+	checksumCallback = callback;
+	checksumContext = context;
+}
+
+#if GPSNMEA_RTCM
+void GPSNMEA::onRtcm(RtcmCallback callback, void *context) {
+	rtcmCallback = callback;
+	rtcmContext = context;
+}
+#endif
+
+bool GPSNMEA::onCommit(uint16_t fields, CommitCallback callback, void *context) {
+	if (callback == nullptr)
+		return false;
+	for (uint8_t i = 0; i < commitHandlerCount; ++i) {
+		if (commitHandlers[i].callback == callback && commitHandlers[i].context == context) {
+			commitHandlers[i].fields = fields;
+			return true;
 		}
-	} else if (termNumber == 2) {
-		gps.gsa.fixType = atoi(term);
-	} else if (termNumber >= 3 && termNumber <= 14) {
-		int index = termNumber - 3;
-		if (index >= 0 && index < 12) {
-			gps.gsa.satPrn[index] = atoi(term);
+	}
+	if (commitHandlerCount >= GPSNMEA_MAX_COMMIT_CALLBACKS)
+		return false;
+	CommitHandler &c = commitHandlers[commitHandlerCount++];
+	c.fields = fields;
+	c.callback = callback;
+	c.context = context;
+	return true;
+}
+
+void GPSNMEA::removeCommitCallback(CommitCallback callback, void *context) {
+	for (uint8_t i = 0; i < commitHandlerCount; ++i) {
+		if (commitHandlers[i].callback == callback && commitHandlers[i].context == context) {
+			// 登録順を保ったまま詰める
+			for (uint8_t j = i + 1; j < commitHandlerCount; ++j)
+				commitHandlers[j - 1] = commitHandlers[j];
+			--commitHandlerCount;
+			return;
 		}
-	} else if (termNumber == 15) {
-		gps.gsa.pdop = atof(term);
-	} else if (termNumber == 16) {
-		gps.gsa.hdop = atof(term);
-	} else if (termNumber == 17) {
-		gps.gsa.vdop = atof(term);
-	}
-}
-
-void GPSNMEA::parseGSVTerm(int termNumber, const char *term, GPSNMEA &gps) {
-	if (termNumber == 1) {
-		gps.gsv.totalMessages = atoi(term);
-	} else if (termNumber == 2) {
-		gps.gsv.messageNumber = atoi(term);
-	} else if (termNumber == 3) {
-		gps.gsv.satellitesInView = atoi(term);
-	} else if (termNumber >= 4) {
-		int fieldIndex = termNumber - 4;
-		int satIndex = fieldIndex / 4;
-		int field = fieldIndex % 4;
-		if (satIndex < 4) {
-			switch(field) {
-				case 0: gps.gsv.satellites[satIndex].prn       = atoi(term); break;
-				case 1: gps.gsv.satellites[satIndex].elevation = atoi(term); break;
-				case 2: gps.gsv.satellites[satIndex].azimuth   = atoi(term); break;
-				case 3: gps.gsv.satellites[satIndex].snr       = atoi(term); break;
-			}
+	}
+}
+
+void GPSNMEA::clearCallbacks() {
+	memset(sentenceHandlers, 0, sizeof(sentenceHandlers));
+	checksumCallback = nullptr;
+	checksumContext = nullptr;
+#if GPSNMEA_RTCM
+	rtcmCallback = nullptr;
+	rtcmContext = nullptr;
+#endif
+	memset(commitHandlers, 0, sizeof(commitHandlers));
+	commitHandlerCount = 0;
+}
+
+void GPSNMEA::commitSentence() {
+	// センテンス種類ごとのcommit
+	uint16_t (*commit)(GPSNMEA &) = loadTable(kSchemas[curSentenceType]).commit;
+	if (commit != nullptr)
+		committedMask = commit(*this);
+}
+
+void GPSNMEA::publishSnapshot() {
+	// updated フラグを落とさないよう、value() ではなく内部値を直接読む
+	GPSSnapshot s;
+	memset(&s, 0, sizeof(s));  // パディングも含めて毎回同じ内容にする
+	s.lat = location.rawLatData;
+	s.lng = location.rawLngData;
+	s.time = time.time;
+	s.date = static_cast<uint32_t>(date.date);
+	s.speed = speed.val;
+	s.course = course.val;
+	s.altitude = altitude.val;
+	s.hdop = hdop.val;
+	s.satellites = static_cast<int32_t>(satellites.val);
+	if (gsa.valid) {
+		s.pdop = gsa.pdop;
+		s.vdop = gsa.vdop;
+		s.fixType = static_cast<uint8_t>(gsa.fixType);
+	}
+	s.hasFix = sentenceHasFix;
+	s.validFields = static_cast<uint16_t>(
+		(location.valid ? Field_Location : 0) | (time.valid ? Field_Time : 0) |
+		(date.valid ? Field_Date : 0) | (speed.valid ? Field_Speed : 0) |
+		(course.valid ? Field_Course : 0) | (satellites.valid ? Field_Satellites : 0) |
+		(hdop.valid ? Field_Hdop : 0) | (altitude.valid ? Field_Altitude : 0) |
+		(gsa.valid ? Field_GSA : 0) | (gsv.valid ? Field_GSV : 0) |
+		(vtg.valid ? Field_VTG : 0));
+	s.updatedFields = committedMask;
+	s.sentenceCount = passedChecksumCount;
+	s.commitTime = gpsMillis();
+	snapshotLock.write(s);
+}
+
+void GPSNMEA::handleTerm(const char *term, size_t len) {
+	// センテンス名（termNumber=0）を解析
+	if (curTermNumber == 0) {
+		// 例: "GPRMC", "GLGSV", "GNGSA" など
+		curSentenceType = classifyAddress(term, len, curTalker);
+		void (*begin)(GPSNMEA &) = loadTable(kSchemas[curSentenceType]).begin;
+		if (begin != nullptr)
+			begin(*this);
+
+		// カスタム登録をセンテンス名のハッシュで引く
+		customSentence = (customSentenceCount != 0) ? findCustomSentence(term, len) : nullptr;
+		customCursor = (customSentence != nullptr) ? customSentence->head : nullptr;
+		if (customSentence != nullptr)
+			termLimit = TERM_BUFFER_LENGTH - 1;
+
+		// 購読対象外で、カスタムフィールドも無ければ以降のtermは読み飛ばす
+		skipSentence = !(subscribedMask & sentenceBit(curSentenceType)) && customSentence == nullptr;
+		return;
+	}
+
+	// 本文のパース (スキーマ表を1回引く)
+	//  term は ',' '*' などで終わるビューの場合もある。各パーサは数字以外で読み取りを止める
+	//  subscribedMask は GPSNMEA_SENTENCES との積なので、無効な種別の表(空)は引かない
+	if (len != 0 && (subscribedMask & sentenceBit(curSentenceType))) {
+		const SentenceSchema schema = loadTable(kSchemas[curSentenceType]);
+		if (curTermNumber < schema.termCount) {
+			const TermRule rule = loadTable(schema.terms[curTermNumber]);
+			if (rule.parse != nullptr)
+				rule.parse(*this, term, rule.arg);
 		}
 	}
+
+	// カスタムフィールドの更新 (ビットマップで登録の無いtermは即座に除外)
+	if (customSentence != nullptr &&
+		(customSentence->termMask & (1UL << (curTermNumber < 31 ? curTermNumber : 31))))
+	{
+		while (customCursor != nullptr && customCursor->termNumber < curTermNumber)
+			customCursor = customCursor->next;
+		for (GPSCustom *p = customCursor; p != nullptr && p->termNumber == curTermNumber; p = p->next)
+			p->set(term, len);
+	}
 }
 
-void GPSNMEA::parseVTGTerm(int termNumber, const char *term, GPSNMEA &gps) {
-	// VTG: True Track, T, Magnetic Track, M, Speed (knots), N, Speed (km/h), K
-	if (termNumber == 1) {
-		gps.vtg.trueTrack = atof(term);
-	} else if (termNumber == 3) {
-		gps.vtg.magneticTrack = atof(term);
-	} else if (termNumber == 5) {
-		gps.vtg.speedKnots = atof(term);
-	} else if (termNumber == 7) {
-		gps.vtg.speedKmph = atof(term);
+bool GPSNMEA::commitGSVPage() {
+	// term4以降の本文term数から、衛星数と末尾の signal ID の有無を求める
+	int satTerms = curTermNumber - 4;
+	if (satTerms < 0)
+		satTerms = 0;
+	int nSats = satTerms / 4;
+	if (nSats > 4)
+		nSats = 4;
+	if (satTerms % 4 == 1 && nSats < 4) {
+		// signal ID は次の衛星のPRN欄として読まれている
+		gsv.signalId = gsv.satellites[nSats].prn;
+		gsv.satellites[nSats].prn = 0;
 	}
+
+#if GPSNMEA_SATELLITE_TABLE
+	GPSSatellite page[4];
+	for (int i = 0; i < nSats; ++i) {
+		page[i].prn = static_cast<uint16_t>(gsv.satellites[i].prn);
+		page[i].elevation = static_cast<int8_t>(gsv.satellites[i].elevation);
+		page[i].azimuth = static_cast<uint16_t>(gsv.satellites[i].azimuth);
+		page[i].snr = static_cast<uint8_t>(gsv.satellites[i].snr);
+		page[i].talker = static_cast<uint8_t>(curTalker);
+		page[i].signalId = static_cast<uint8_t>(gsv.signalId);
+	}
+	return satelliteTable.addPage(static_cast<uint8_t>(curTalker), static_cast<uint8_t>(gsv.signalId),
+		gsv.totalMessages, gsv.messageNumber, page, nSats);
+#else
+	return false;
+#endif
 }
 
 //=================================================================
@@ -440,8 +1802,9 @@ void GPSLocation::commit() {
 	rawLngData = rawNewLngData;
 	valid = true;
 	updated = true;
-	lastCommitTime = millis();
+	lastCommitTime = gpsMillis();
 }
+#if !GPSNMEA_NO_DOUBLE
 double GPSLocation::lat() {
 	updated = false;
 	double ret = rawLatData.deg + rawLatData.billionths / 1000000000.0;
@@ -452,62 +1815,53 @@ double GPSLocation::lng() {
 	double ret = rawLngData.deg + rawLngData.billionths / 1000000000.0;
 	return rawLngData.negative ? -ret : ret;
 }
+#endif
 
 //-----------------------------------
 GPSTime::GPSTime()
-: time(0), newTime(0), lastCommitTime(0), valid(false), updated(false)
+: time(0), newTime(0), msOfDay(0), hh(0), mm(0), ss(0), cs(0), valid(false), updated(false), lastCommitTime(0)
 {}
 void GPSTime::setTime(const char *term) {
 	newTime = static_cast<uint32_t>(gpsParseDecimal(term));
 }
 void GPSTime::commit() {
-	time = newTime;
+	if (newTime != time || !valid) {
+		// 時・分・秒などへの分解はここで1回だけ行う
+		time = newTime;
+		uint32_t hms = time / 100;
+		cs = time % 100;
+		ss = hms % 100;
+		mm = (hms / 100) % 100;
+		hh = hms / 10000;
+		msOfDay = ((hh * 60UL + mm) * 60 + ss) * 1000 + cs * 10;
+	}
 	valid = true;
 	updated = true;
-	lastCommitTime = millis();
-}
-uint8_t GPSTime::hour() {
-	updated = false;
-	return time / 1000000;
-}
-uint8_t GPSTime::minute() {
-	updated = false;
-	return (time / 10000) % 100;
-}
-uint8_t GPSTime::second() {
-	updated = false;
-	return (time / 100) % 100;
-}
-uint8_t GPSTime::centisecond() {
-	updated = false;
-	return time % 100;
+	lastCommitTime = gpsMillis();
 }
 
 //-----------------------------------
 GPSDate::GPSDate()
-: date(0), newDate(0), lastCommitTime(0), valid(false), updated(false)
+: date(0), newDate(0), fullYear(0), newFullYear(0), days(0), yr(0), mo(0), dy(0),
+	valid(false), updated(false), lastCommitTime(0)
 {}
 void GPSDate::setDate(const char *term) {
-	newDate = atol(term);
+	newDate = static_cast<uint32_t>(gpsParseInt(term));
+	newFullYear = 0;
 }
 void GPSDate::commit() {
-	date = newDate;
+	if (newDate != date || newFullYear != fullYear || !valid) {
+		// 日付が変わった時だけ分解し、1970-01-01 からの日数を求め直す
+		date = newDate;
+		fullYear = newFullYear;
+		dy = date / 10000;
+		mo = (date / 100) % 100;
+		yr = fullYear != 0 ? fullYear : gpsFullYear(date % 100);
+		days = (dy >= 1 && dy <= 31 && mo >= 1 && mo <= 12) ? gpsDaysFromCivil(yr, mo, dy) : 0;
+	}
 	valid = true;
 	updated = true;
-	lastCommitTime = millis();
-}
-uint16_t GPSDate::year() {
-	updated = false;
-	uint16_t yr = date % 100;
-	return yr + 2000;
-}
-uint8_t GPSDate::month() {
-	updated = false;
-	return (date / 100) % 100;
-}
-uint8_t GPSDate::day() {
-	updated = false;
-	return date / 10000;
+	lastCommitTime = gpsMillis();
 }
 
 //-----------------------------------
@@ -521,7 +1875,7 @@ void GPSDecimal::commit() {
 	val = newval;
 	valid = true;
 	updated = true;
-	lastCommitTime = millis();
+	lastCommitTime = gpsMillis();
 }
 
 //-----------------------------------
@@ -529,62 +1883,114 @@ GPSInteger::GPSInteger()
 : val(0), newval(0), lastCommitTime(0), valid(false), updated(false)
 {}
 void GPSInteger::set(const char *term) {
-	newval = atol(term);
+	newval = gpsParseInt(term);
 }
 void GPSInteger::commit() {
 	val = newval;
 	valid = true;
 	updated = true;
-	lastCommitTime = millis();
+	lastCommitTime = gpsMillis();
 }
 
 //-----------------------------------
 GPSCustom::GPSCustom()
 	: sentenceName(nullptr), termNumber(0), next(nullptr),
-	valid(false), updated(false), lastCommitTime(0)
+	registered(false), valid(false), updated(false), lastCommitTime(0)
 {
 	stagingBuffer[0] = '\0';
 	buffer[0] = '\0';
 }
 
-GPSCustom::GPSCustom(GPSNMEA &gps, const char *sentenceName, int termNumber) {
+GPSCustom::GPSCustom(GPSNMEA &gps, const char *sentenceName, int termNumber)
+	: GPSCustom()
+{
 	begin(gps, sentenceName, termNumber);
 }
 
-void GPSCustom::begin(GPSNMEA &gps, const char *sentenceName, int termNumber) {
+bool GPSCustom::begin(GPSNMEA &gps, const char *sentenceName, int termNumber) {
 	lastCommitTime = 0;
 	valid = false;
 	updated = false;
 	this->sentenceName = sentenceName;
 	this->termNumber = termNumber;
+	next = nullptr;
 	stagingBuffer[0] = '\0';
 	buffer[0] = '\0';
-	gps.insertCustom(this, sentenceName, termNumber);
+	registered = gps.insertCustom(this, sentenceName, termNumber);
+	return registered;
 }
 
 void GPSCustom::commit() {
 	strcpy(buffer, stagingBuffer);
 	valid = true;
 	updated = true;
-	lastCommitTime = millis();
+	lastCommitTime = gpsMillis();
 }
 
-void GPSCustom::set(const char *term) {
-	strncpy(stagingBuffer, term, sizeof(stagingBuffer) - 1);
-	stagingBuffer[sizeof(stagingBuffer) - 1] = '\0';
+void GPSCustom::set(const char *term, size_t len) {
+	if (len > sizeof(stagingBuffer) - 1)
+		len = sizeof(stagingBuffer) - 1;
+	memcpy(stagingBuffer, term, len);
+	stagingBuffer[len] = '\0';
 }
 
 //=================================================================
 // カスタムフィールド管理
 //=================================================================
-void GPSNMEA::insertCustom(GPSCustom *pElt, const char *sentenceName, int termNumber) {
-	GPSCustom **pp = &customElts;
-	while (*pp != nullptr) {
-		int cmp = strcmp(sentenceName, (*pp)->sentenceName);
-		if (cmp < 0 || (cmp == 0 && termNumber < (*pp)->termNumber))
-			break;
-		pp = &((*pp)->next);
+uint32_t GPSNMEA::hashSentenceName(const char *name, size_t len) {
+	// FNV-1a
+	uint32_t h = 2166136261UL;
+	for (size_t i = 0; i < len; ++i) {
+		h ^= static_cast<uint8_t>(name[i]);
+		h *= 16777619UL;
+	}
+	return h;
+}
+
+GPSNMEA::CustomSentence *GPSNMEA::findCustomSentence(const char *name, size_t len) {
+	uint32_t h = hashSentenceName(name, len);
+	for (unsigned slot = h & (CUSTOM_SLOTS - 1); customTable[slot].name != nullptr;
+		slot = (slot + 1) & (CUSTOM_SLOTS - 1))
+	{
+		CustomSentence &e = customTable[slot];
+		if (e.hash == h && compareSentenceName(e.name, name, len) == 0)
+			return &e;
 	}
+	return nullptr;
+}
+
+bool GPSNMEA::insertCustom(GPSCustom *pElt, const char *sentenceName, int termNumber) {
+	size_t len = strlen(sentenceName);
+	CustomSentence *e = findCustomSentence(sentenceName, len);
+	if (e == nullptr) {
+		if (customSentenceCount >= GPSNMEA_MAX_CUSTOM_SENTENCES)
+			return false;
+		uint32_t h = hashSentenceName(sentenceName, len);
+		unsigned slot = h & (CUSTOM_SLOTS - 1);
+		while (customTable[slot].name != nullptr)
+			slot = (slot + 1) & (CUSTOM_SLOTS - 1);
+		e = &customTable[slot];
+		e->name = sentenceName;
+		e->hash = h;
+		e->termMask = 0;
+		e->head = nullptr;
+		++customSentenceCount;
+	}
+
+	// termNumber 順に挿入
+	GPSCustom **pp = &e->head;
+	while (*pp != nullptr && (*pp)->termNumber <= termNumber)
+		pp = &((*pp)->next);
 	pElt->next = *pp;
 	*pp = pElt;
+	if (termNumber >= 0)
+		e->termMask |= 1UL << (termNumber < 31 ? termNumber : 31);
+	return true;
+}
+
+void GPSNMEA::clearCustom() {
+	memset(customTable, 0, sizeof(customTable));
+	customSentenceCount = 0;
+	customSentence = nullptr;
+	customCursor = nullptr;
 }
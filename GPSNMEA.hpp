@@ -5,6 +5,11 @@
 #include <stddef.h>
 #include <string.h>
 
+#include "GPSNMEAConfig.hpp"
+#include "GPSNMEAAtomic.hpp"
+#include "GPSSatelliteTable.hpp"
+#include "GPSRtcm.hpp"
+
 // 緯度・経度などの度数表示用
 struct RawDegrees {
 	uint8_t deg;            // 度の整数部分
@@ -12,9 +17,25 @@ struct RawDegrees {
 	bool negative;          // 南緯、または西経なら true
 };
 
+// 起動からの経過ミリ秒 (Arduinoでは millis()、ホストビルドでは steady_clock)
+unsigned long gpsMillis();
+
+// n 以上で最小の2のべき (固定長ハッシュ表の大きさ用)
+constexpr int gpsPow2AtLeast(int n, int p = 1) {
+	return p >= n ? p : gpsPow2AtLeast(n, p * 2);
+}
+
 // 16進文字 -> 数値変換
 int gpsFromHex(char a);
 
+// 数値文字列 -> 小数点以下 fracDigits 桁の固定小数点整数 (10^fracDigits 倍) として返す
+//  1回の走査で読み、fracDigits より下の桁は切り捨てる。数字以外の文字で読み取りを止める
+//  例: gpsParseFixed("12.3456", 3) => 12345
+int32_t gpsParseFixed(const char *term, uint8_t fracDigits);
+
+// 整数文字列 -> 整数 (小数部は切り捨て)
+int32_t gpsParseInt(const char *term);
+
 // 数値文字列 -> (100倍の整数値)として返す
 //  例: "1234.56" => 123456
 int32_t gpsParseDecimal(const char *term);
@@ -22,13 +43,64 @@ int32_t gpsParseDecimal(const char *term);
 // 緯度・経度文字列を度数表現(RawDegrees)へ変換
 void gpsParseDegrees(const char *term, RawDegrees &deg);
 
+// 度数表現 -> 1e-7度単位の符号付き整数 (小数第8位以下は四捨五入)
+int32_t gpsDegreesE7(const RawDegrees &deg);
+// 1e-7度単位の符号付き整数 -> 度数表現 (UBX の緯度・経度などから)
+void gpsDegreesFromE7(int32_t e7, RawDegrees &deg);
+
+// 西暦の年月日 -> 1970-01-01 からの日数 (グレゴリオ暦、1970年より前は負)
+int32_t gpsDaysFromCivil(int32_t year, unsigned month, unsigned day);
+
+// 2桁の年 -> 西暦 (GPSNMEA_CENTURY_PIVOT 以上は1900年代、未満は2000年代)
+inline uint16_t gpsFullYear(unsigned yy) {
+	return static_cast<uint16_t>(yy + (yy >= GPSNMEA_CENTURY_PIVOT ? 1900 : 2000));
+}
+
+// 日付(ddmmyy) -> 1970-01-01 からの日数。日付として不正(0など)なら false
+bool gpsDateToDays(uint32_t date, int32_t &days);
+
+// 時刻(hhmmsscc) -> その日の0時からのミリ秒
+inline uint32_t gpsMillisOfDay(uint32_t time) {
+	return ((time / 1000000) * 3600 + ((time / 10000) % 100) * 60 + (time / 100) % 100) * 1000UL +
+		(time % 100) * 10;
+}
+
+// 日付(ddmmyy)と時刻(hhmmsscc) -> 1970-01-01 00:00:00 UTC からのミリ秒
+//  date が日付として不正(0など)なら、その日の0時からのミリ秒
+//  (同じ日付で何度も変換するなら GPSDate::daysSinceEpoch() などで日数を使い回す方が速い)
+int64_t gpsEpochMillis(uint32_t date, uint32_t time);
+
 // 方位角(deg)を16方位(N, NNE, NEなど)の文字列として返す
+#if !GPSNMEA_NO_DOUBLE
 const char* gpsCardinal(double course);
+#endif
+// 同じく、度 x100 の整数(GPSNMEA::course.value() など)から。浮動小数点演算を使わない
+const char* gpsCardinalX100(int32_t course);
+
+// [p, end) から区切り文字($ , * \r \n)を探し、最初の位置を返す (無ければ end)
+//  SSE2/AVX2/NEON が使える環境ではベクトル幅で走査する
+const char* gpsFindDelimiter(const char *p, const char *end);
+
+// バイト列全体のXOR (NMEAチェックサム計算用)
+uint8_t gpsXorBytes(const char *p, size_t len);
+
+// UBXフレームのチェックサム (8bit Fletcher)。ck_a, ck_b に続きから加算する
+//  対象はクラスからペイロード末尾まで (同期文字 0xB5 0x62 は含めない)
+inline void gpsUbxChecksum(const uint8_t *p, size_t len, uint8_t &ckA, uint8_t &ckB) {
+	uint8_t a = ckA, b = ckB;
+	while (len--) {
+		a += *p++;
+		b += a;
+	}
+	ckA = a;
+	ckB = b;
+}
 
 //=================================================================
 // GPSNMEA クラス本体
 //=================================================================
 class GPSNMEA;  // 前方宣言
+class GPSSentenceView;  // GPSNMEAView.hpp
 
 // ------------------------------
 // 各種データサブクラス
@@ -42,8 +114,15 @@ public:
 	void setLatitude(const char *term);
 	void setLongitude(const char *term);
 	void commit();
+#if !GPSNMEA_NO_DOUBLE
 	double lat();
 	double lng();
+#endif
+	// 1e-7度単位の整数 (u-blox の NAV-PVT と同じ表現)。double を使わないので FPU の無いMCUでも軽い
+	int32_t latE7() { updated = false; return gpsDegreesE7(rawLatData); }
+	int32_t lngE7() { updated = false; return gpsDegreesE7(rawLngData); }
+	const RawDegrees &rawLat() const { return rawLatData; }
+	const RawDegrees &rawLng() const { return rawLngData; }
 
 	bool isValid() const { return valid; }
 	bool isUpdated() const { return updated; }
@@ -55,6 +134,7 @@ private:
 	unsigned long lastCommitTime;
 
 	friend class GPSNMEA; // GPSNMEAのprivate static関数から直接アクセス可
+	friend struct GPSNMEAFields;
 };
 
 // 時刻情報 (RMCなどで使用)
@@ -64,20 +144,27 @@ public:
 
 	void setTime(const char *term);
 	void commit();
-	uint8_t hour();
-	uint8_t minute();
-	uint8_t second();
-	uint8_t centisecond();
+	uint32_t value() { updated = false; return time; }  // hhmmsscc
+	// 各項目は commit() 時に分解済み (読むたびに除算しない)
+	uint8_t hour() { updated = false; return hh; }
+	uint8_t minute() { updated = false; return mm; }
+	uint8_t second() { updated = false; return ss; }
+	uint8_t centisecond() { updated = false; return cs; }
+	// 0時からのミリ秒
+	uint32_t millisOfDay() const { return msOfDay; }
 
 	bool isValid() const { return valid; }
 	bool isUpdated() const { return updated; }
 
 private:
 	uint32_t time, newTime;
+	uint32_t msOfDay;
+	uint8_t hh, mm, ss, cs;
 	bool valid, updated;
 	unsigned long lastCommitTime;
 
 	friend class GPSNMEA;
+	friend struct GPSNMEAFields;
 };
 
 // 日付情報 (RMCで使用)
@@ -87,19 +174,29 @@ public:
 
 	void setDate(const char *term);
 	void commit();
-	uint16_t year();
-	uint8_t month();
-	uint8_t day();
+	uint32_t value() { updated = false; return date; }  // ddmmyy
+	// 各項目は commit() 時に分解済み。年は GPSNMEA_CENTURY_PIVOT で4桁にする
+	uint16_t year() { updated = false; return yr; }
+	uint8_t month() { updated = false; return mo; }
+	uint8_t day() { updated = false; return dy; }
+	// 1970-01-01 からの日数 (日付として不正なら 0)
+	//  日付が変わった commit() でだけ計算し直す
+	int32_t daysSinceEpoch() const { return days; }
 
 	bool isValid() const { return valid; }
 	bool isUpdated() const { return updated; }
 
 private:
-	long date, newDate;
+	uint32_t date, newDate;
+	uint16_t fullYear, newFullYear;  // 4桁の年が届いた(ZDA)場合の年。0 なら yy から決める
+	int32_t days;
+	uint16_t yr;
+	uint8_t mo, dy;
 	bool valid, updated;
 	unsigned long lastCommitTime;
 
 	friend class GPSNMEA;
+	friend struct GPSNMEAFields;
 };
 
 // 小数値 (speed, course, hdop, altitudeなど)
@@ -120,6 +217,7 @@ private:
 	unsigned long lastCommitTime;
 
 	friend class GPSNMEA;
+	friend struct GPSNMEAFields;
 };
 
 // 整数値 (衛星数など)
@@ -140,6 +238,7 @@ private:
 	unsigned long lastCommitTime;
 
 	friend class GPSNMEA;
+	friend struct GPSNMEAFields;
 };
 
 // カスタムフィールド (特定のtermを取得したい場合に使用)
@@ -148,42 +247,227 @@ public:
 	GPSCustom();
 	GPSCustom(GPSNMEA &gps, const char *sentenceName, int termNumber);
 
-	void begin(GPSNMEA &gps, const char *sentenceName, int termNumber);
+	// 登録。センテンス名の登録数が GPSNMEA_MAX_CUSTOM_SENTENCES を超える場合は false
+	//  (1つのセンテンス名に登録できるterm数は無制限)
+	bool begin(GPSNMEA &gps, const char *sentenceName, int termNumber);
+	// 登録できたか (コンストラクタで登録した場合の確認用)
+	bool isRegistered() const { return registered; }
 
+	// termをそのまま返す。GPSNMEA_MAX_CUSTOM_LENGTH - 1 文字を超える部分は切り詰める
 	const char *value() { updated = false; return buffer; }
 	bool isValid() const { return valid; }
 	bool isUpdated() const { return updated; }
 
 private:
 	void commit();
-	void set(const char *term);
+	void set(const char *term, size_t len);
 
 	const char *sentenceName;
 	int termNumber;
-	GPSCustom *next;
+	GPSCustom *next;   // 同じセンテンス内で termNumber 順に並ぶ
 
-	char stagingBuffer[16];
-	char buffer[16];
+	char stagingBuffer[GPSNMEA_MAX_CUSTOM_LENGTH];
+	char buffer[GPSNMEA_MAX_CUSTOM_LENGTH];
 
+	bool registered;
 	bool valid, updated;
 	unsigned long lastCommitTime;
 
 	friend class GPSNMEA;  // GPSNMEA から commit/set呼び出し可
 };
 
+// commit済み項目の一貫したコピー (GPSNMEA::snapshot() で取得)
+//  センテンスのcommitごとにまとめて公開されるため、別スレッドや割り込み外から
+//  読んでも緯度と経度、時刻と日付などが別々のセンテンスの値で混ざらない
+struct GPSSnapshot {
+	RawDegrees lat;
+	RawDegrees lng;
+	uint32_t time;           // hhmmsscc
+	uint32_t date;           // ddmmyy
+	int32_t speed;           // ノット x100
+	int32_t course;          // 度 x100
+	int32_t altitude;        // m x100
+	int32_t hdop;            // x100
+	int32_t satellites;
+	int32_t pdop;            // GSA x100
+	int32_t vdop;            // GSA x100
+	uint8_t fixType;         // GSA 1=NoFix,2=2D,3=3D (未受信なら0)
+	bool hasFix;             // 直前のセンテンスが測位有効だったか
+	uint16_t validFields;    // 一度でもcommitされた項目 (GPSNMEA::Field_xxx のビット和)
+	uint16_t updatedFields;  // 直前のセンテンスでcommitされた項目
+	uint32_t sentenceCount;  // 公開時点の passedChecksumCount
+	unsigned long commitTime; // 公開時の gpsMillis()
+};
+
 // ------------------------------
 // メインクラス: GPSNMEA
 // ------------------------------
 class GPSNMEA {
 public:
-	static const int MAX_TERM_LENGTH = 20;
+	static const int MAX_TERM_LENGTH = GPSNMEA_MAX_TERM_LENGTH;
+	// termBuffer の長さ (GPSCustom の登録があるセンテンスは GPSNMEA_MAX_CUSTOM_LENGTH まで溜める)
+	static const int TERM_BUFFER_LENGTH =
+		(GPSNMEA_MAX_CUSTOM_LENGTH > GPSNMEA_MAX_TERM_LENGTH) ? GPSNMEA_MAX_CUSTOM_LENGTH : GPSNMEA_MAX_TERM_LENGTH;
+	static_assert(TERM_BUFFER_LENGTH <= 255, "GPSNMEA_MAX_TERM_LENGTH/GPSNMEA_MAX_CUSTOM_LENGTH must be 255 or less");
+
+	// センテンス種別
+	enum SentenceType {
+		SentenceType_Other,
+		SentenceType_RMC,
+		SentenceType_GGA,
+		SentenceType_GSA,
+		SentenceType_GSV,
+		SentenceType_VTG,
+		SentenceType_GLL,
+		SentenceType_ZDA,
+		SentenceType_GST,
+		SentenceType_GNS,
+		SentenceType_GBS,
+		SentenceType_NAVPVT,  // UBX-NAV-PVT (バイナリ。GPSNMEA_UBX が 1 の時)
+		SentenceType_NAVSAT,  // UBX-NAV-SAT (同上)
+		SentenceType_Count  // 種別の数 (センテンス種別ではない)
+	};
+
+	// トーカーID (アドレスフィールドの先頭2文字)
+	enum Talker {
+		Talker_Unknown,
+		Talker_GP,  // GPS
+		Talker_GL,  // GLONASS
+		Talker_GA,  // Galileo
+		Talker_GB,  // BeiDou
+		Talker_BD,  // BeiDou (NMEA 4.10 以前の表記)
+		Talker_GQ,  // QZSS
+		Talker_QZ,  // QZSS (一部受信機の表記)
+		Talker_GI,  // NavIC (IRNSS)
+		Talker_GN,  // 複数の衛星系を組み合わせた解
+		Talker_Count  // トーカーの数 (トーカーではない)
+	};
+
+	// 直前のセンテンスでcommitされた項目 (committedFields() のビット)
+	enum Field {
+		Field_Location   = 1 << 0,
+		Field_Time       = 1 << 1,
+		Field_Date       = 1 << 2,
+		Field_Speed      = 1 << 3,
+		Field_Course     = 1 << 4,
+		Field_Satellites = 1 << 5,
+		Field_Hdop       = 1 << 6,
+		Field_Altitude   = 1 << 7,
+		Field_GSA        = 1 << 8,
+		Field_GSV        = 1 << 9,
+		Field_VTG        = 1 << 10,
+		Field_SatelliteTable = 1 << 11, // GSVサイクルが揃い衛星テーブルを更新した
+		Field_GST        = 1 << 12,
+		Field_GBS        = 1 << 13,
+		Field_PVT        = 1 << 14  // UBX-NAV-PVT の pvt (NMEA に無い項目)
+	};
+
+	// コールバック (encode()/decode() の中から呼ばれる。中で encode() を呼ばないこと)
+	//  センテンスのチェックサムが一致した
+	typedef void (*SentenceCallback)(GPSNMEA &gps, void *context);
+	//  チェックサムが一致しなかった (received は '*' の後の値、computed は計算値)
+	//  UBXフレームでは ck_a, ck_b のうち一致しなかった方 (両方なら ck_a)
+	typedef void (*ChecksumCallback)(GPSNMEA &gps, uint8_t received, uint8_t computed, void *context);
+	//  登録した項目のいずれかがcommitされた (fields は commit された項目のうち登録分)
+	typedef void (*CommitCallback)(GPSNMEA &gps, uint16_t fields, void *context);
+	//  CRC-24Q が一致した RTCM3 フレーム (GPSNMEA_RTCM が 1 の時)。frame はコールバック中のみ有効
+	typedef void (*RtcmCallback)(GPSNMEA &gps, const GPSRtcmFrame &frame, void *context);
 
 	GPSNMEA();
 	void reset();
 
 	// 受信バイトを1文字ずつ渡してデコード。trueが返れば文末(Checksumまで)が処理完了
+	//  GPSNMEA_UBX が 1 なら、NMEA の間に挟まった UBX フレームも同じ経路で受け取る
+	//  (UBXフレームもチェックサムが一致すれば true。センテンスの途中に挟まることは想定しない)
 	bool encode(char c);
 
+	// 受信バッファをまとめてデコード。チェックサムまで処理完了したセンテンス(とUBXフレーム)数を返す
+	//  結果は encode(char) を1文字ずつ呼んだ場合と同一
+	size_t encode(const char *buf, size_t len);
+
+	// 切り出し済みの1センテンス(ビュー)を、termBufferへコピーせずにデコード
+	//  チェックサムが一致すれば true。統計やcommitは encode() と同じく更新される
+	bool decode(const GPSSentenceView &sentence);
+
+	// 受信時にパースするセンテンスを指定する (GPSNMEA_SENTENCE_xxx のビット和)
+	//  対象外のセンテンスはtermのバッファリングもパースもせず、チェックサム確認だけ行う
+	//  (GPSCustom が登録されているセンテンスは対象外でもパースする)
+	//  実際に有効になるのはコンパイル時の GPSNMEA_SENTENCES との積
+	void subscribe(uint32_t mask) { subscribedMask = mask & GPSNMEA_SENTENCES; }
+	uint32_t subscription() const { return subscribedMask; }
+	static uint32_t sentenceBit(SentenceType type) { return 1UL << type; }
+
+	// コールバック登録 (ヒープは使わない。callback = nullptr で解除)
+	//  onSentence: 種別ごとに1つ。購読対象外で読み飛ばしたセンテンスでも呼ばれる
+	void onSentence(SentenceType type, SentenceCallback callback, void *context = nullptr);
+	void onChecksumError(ChecksumCallback callback, void *context = nullptr);
+	//  onCommit: fields (Field_xxx のビット和) ごとに最大 GPSNMEA_MAX_COMMIT_CALLBACKS 個。
+	//  同じ callback と context の組なら fields を置き換える。登録できなければ false
+	bool onCommit(uint16_t fields, CommitCallback callback, void *context = nullptr);
+	void removeCommitCallback(CommitCallback callback, void *context = nullptr);
+#if GPSNMEA_RTCM
+	//  onRtcm: RTCM3 フレームを1つずつ渡す (NMEA のパースは止めずに続ける)
+	//  encode(buf, len) の buf にフレーム全体が収まっていれば buf を直接指すビュー、
+	//  呼び出しをまたいだフレームは内部バッファで組み立てたもののビュー
+	void onRtcm(RtcmCallback callback, void *context = nullptr);
+#endif
+	void clearCallbacks();
+
+	// 5文字のアドレスフィールド(例: "GLGSV")を分類する。標準外なら SentenceType_Other
+	static SentenceType classifyAddress(const char *address, size_t len, Talker &talker);
+
+	// 処理中(またはチェックサムまで処理し終えた直前)のセンテンス種別とトーカー
+	SentenceType sentenceType() const { return curSentenceType; }
+	Talker talker() const { return curTalker; }
+	// 直前のセンテンスが測位有効(RMC:'A', GGA:品質>0)だったか
+	bool sentenceFix() const { return sentenceHasFix; }
+	// 直前にチェックサムが一致したセンテンスでcommitされた項目 (Field_xxx のビット和)
+	uint16_t committedFields() const { return committedMask; }
+
+	// commit済み項目の一貫したコピーを取得する (ロックなし)
+	//  encode() と別スレッド(または割り込み)から呼べる。書き込みと重なれば読み直す
+	void snapshot(GPSSnapshot &out) const { snapshotLock.read(out); }
+	// 1回だけ試す版。encode() を呼ぶ側より優先度の高い割り込みから読む場合に使う
+	bool trySnapshot(GPSSnapshot &out) const { return snapshotLock.tryRead(out); }
+	// 公開回数 x2 (変化していれば新しいスナップショットがある。公開中は奇数)
+	GPSSequence snapshotSequence() const { return snapshotLock.sequence(); }
+
+	// commit済みの日付と時刻 -> 1970-01-01 00:00:00 UTC からのミリ秒/ナノ秒
+	//  日数は GPSDate にキャッシュ済みなので、掛け算と足し算だけで求まる
+	//  GGA の時刻だけが0時を越えた(日付はまだ前日)場合は1日進める。日付が無効ならその日の0時から
+	int64_t epochMillis() const {
+		int32_t d = date.days;
+		if (time.msOfDay + 43200000UL < dateMillisOfDay)
+			++d;
+		return static_cast<int64_t>(d) * 86400000 + time.msOfDay;
+	}
+	int64_t epochNanos() const { return epochMillis() * 1000000; }
+
+#if GPSNMEA_INSTRUMENTATION
+	// パーサの計測値 (GPSNMEA_INSTRUMENTATION=1 の時のみ)
+	struct Stats {
+		uint32_t sentences[SentenceType_Count];      // チェックサム一致数 (Other は未対応の種別)
+		uint32_t checksumErrors[SentenceType_Count]; // チェックサム不一致数
+		uint32_t talkers[Talker_Count];              // チェックサム一致数 (トーカー別)
+		uint32_t truncatedTerms;      // MAX_TERM_LENGTH-1 文字 (カスタム登録のあるセンテンスは TERM_BUFFER_LENGTH-1 文字) に切り詰めたterm
+		uint32_t oversizedSentences;  // GPSNMEA_MAX_SENTENCE_LENGTH を超えたセンテンス
+		uint32_t resyncs;             // センテンスの途中で '$' が来て読み捨てた回数
+		uint32_t garbageBytes;        // センテンス外で受け取った改行以外のバイト
+		// センテンス1つのパース時間 (種別別、チェックサム不一致も含む)
+		//  バケット k は [2^k, 2^(k+1)) tick、最後のバケットはそれ以上すべて
+		//  encode(buf, len) と decode() の中で費やした時間だけを数え、呼び出しの合間は含まない
+		//  encode(char) だけで受け取ったセンテンスは計測しない
+		uint32_t parseHistogram[SentenceType_Count][GPSNMEA_STATS_BUCKETS];
+		uint32_t timedSentences[SentenceType_Count];
+		uint64_t parseTicks[SentenceType_Count];     // 計測したパース時間の合計
+	};
+	// 計測値のコピーを取る (encode() と同じスレッドから呼ぶこと)
+	void stats(Stats &out) const { memcpy(&out, &statsData, sizeof(Stats)); }
+	void resetStats();
+	// 計測値を1行のJSONとして buf に書き出す (NUL終端)。必要な長さ(NUL除く)を返す
+	static size_t formatStats(const Stats &stats, char *buf, size_t size);
+#endif
+
 	// --------------------
 	// 取得データ
 	// --------------------
@@ -198,13 +482,20 @@ public:
 
 	// GSA情報
 	struct {
+		Talker talker;  // GN なら複数衛星系の合成
 		char mode;      // 'A'=Auto, 'M'=Manual
 		int fixType;    // 1=NoFix,2=2D,3=3D
 		int satPrn[12];
-		double pdop;
-		double hdop;
-		double vdop;
+		int32_t pdop;   // DOP x100
+		int32_t hdop;
+		int32_t vdop;
 		bool valid;
+
+#if !GPSNMEA_NO_DOUBLE
+		double pdopValue() const { return pdop / 100.0; }
+		double hdopValue() const { return hdop / 100.0; }
+		double vdopValue() const { return vdop / 100.0; }
+#endif
 	} gsa;
 
 	// GSV情報
@@ -215,65 +506,256 @@ public:
 			int azimuth;
 			int snr;
 		};
+		Talker talker;  // このページの衛星系 (GP, GL, GA など)
 		int totalMessages;
 		int messageNumber;
 		int satellitesInView;
-		Satellite satellites[4];
+		Satellite satellites[4];   // このページの衛星 (ページ内に無い分は0)
+		int signalId;              // NMEA 4.10 の signal ID (出力なしなら0)
 		bool valid;
 	} gsv;
 
+#if GPSNMEA_SATELLITE_TABLE
+	// 全ページ・全衛星系を集めたGSV衛星テーブル (サイクル完結ごとに更新)
+	GPSSatelliteTable satelliteTable;
+#endif
+
 	// VTG情報
 	struct {
-		double trueTrack;
-		double magneticTrack;
-		double speedKnots;
-		double speedKmph;
+		int32_t trueTrack;      // 度 x100
+		int32_t magneticTrack;  // 度 x100
+		int32_t speedKnots;     // ノット x100
+		int32_t speedKmph;      // km/h x100
 		bool valid;
+
+#if !GPSNMEA_NO_DOUBLE
+		double trueTrackDeg() const { return trueTrack / 100.0; }
+		double magneticTrackDeg() const { return magneticTrack / 100.0; }
+		double knots() const { return speedKnots / 100.0; }
+		double kmph() const { return speedKmph / 100.0; }
+#endif
 	} vtg;
 
+	// ZDA情報 (日付・時刻は date/time にもcommitされる。年は4桁のまま使う)
+	struct {
+		int day;
+		int month;
+		int year;          // 4桁
+		int zoneHours;     // 現地時間帯 (UTCとの差)
+		int zoneMinutes;
+		bool valid;
+	} zda;
+
+	// GST情報 (擬似距離誤差の統計。m x1000、度 x100)
+	struct {
+		uint32_t time;         // hhmmsscc
+		int32_t rms;           // 擬似距離残差のRMS
+		int32_t sdMajor;       // 誤差楕円の長軸の標準偏差
+		int32_t sdMinor;       // 誤差楕円の短軸の標準偏差
+		int32_t orientation;   // 長軸の向き (真北から、度 x100)
+		int32_t sdLat;         // 緯度・経度・高度の標準偏差
+		int32_t sdLng;
+		int32_t sdAlt;
+		bool valid;
+	} gst;
+
+	// GBS情報 (RAIM による衛星異常検出。m x100)
+	struct {
+		uint32_t time;          // hhmmsscc
+		int32_t errLat;         // 緯度・経度・高度の推定誤差
+		int32_t errLng;
+		int32_t errAlt;
+		int failedSatellite;    // 異常と判定された衛星のID (無ければ0)
+		int32_t probability;    // 見逃し確率 x10000
+		int32_t bias;           // 異常衛星のバイアス推定値
+		int32_t biasSd;         // その標準偏差
+		bool valid;
+	} gbs;
+
+#if GPSNMEA_UBX
+	// UBX-NAV-PVT の、NMEA の項目に無い値 (位置・時刻・速度などは location などへcommitされる)
+	struct {
+		uint32_t iTOW;          // GPS週の経過ミリ秒 (エポックの識別に使う)
+		uint8_t fixType;        // 0=NoFix,1=DR,2=2D,3=3D,4=GNSS+DR,5=時刻のみ
+		uint8_t flags;          // bit0 gnssFixOK, bit1 diffSoln, bit6-7 carrSoln (1=Float,2=Fixed)
+		int32_t height;         // 楕円体高 mm
+		uint32_t hAcc;          // 水平・垂直の推定精度 mm
+		uint32_t vAcc;
+		int32_t velN;           // 北・東・下向きの速度 mm/s
+		int32_t velE;
+		int32_t velD;
+		uint32_t sAcc;          // 速度の推定精度 mm/s
+		int32_t pdop;           // x100
+		bool valid;
+	} pvt;
+
+	// 直前にチェックサムが一致したUBXフレームのクラスとID (class << 8 | id)
+	//  NAV-PVT/NAV-SAT 以外 (ACK など) は SentenceType_Other として onSentence() に届くので、これで見分ける
+	uint16_t ubxMessage() const { return ubxLastMessage; }
+#endif
+
 	// 統計情報
 	uint32_t encodedCharCount;
 	uint32_t sentencesWithFixCount;
 	uint32_t failedChecksumCount;
 	uint32_t passedChecksumCount;
+	uint32_t skippedSentenceCount;   // subscribe() 対象外で読み飛ばしたセンテンス数
+#if GPSNMEA_RTCM
+	uint32_t rtcmFrameCount;         // CRC が一致した RTCM3 フレーム数
+	uint32_t rtcmFailedCount;        // CRC が一致しなかった RTCM3 フレーム数
+#endif
 
 private:
 	// パース中の状態
 	uint8_t parity;
 	bool isChecksumTerm;
 
-	enum SentenceType {
-		SentenceType_Other,
-		SentenceType_RMC,
-		SentenceType_GGA,
-		SentenceType_GSA,
-		SentenceType_GSV,
-		SentenceType_VTG
-	};
 	SentenceType curSentenceType;
+	Talker curTalker;
+	uint16_t committedMask;
+	uint32_t dateMillisOfDay;  // 日付をcommitした時の時刻 (0時越えの判定用)
 
 	uint8_t curTermNumber;
 	uint8_t curTermOffset;
 	bool sentenceHasFix;
 
-	char termBuffer[MAX_TERM_LENGTH];
+	// 購読設定と、処理中のセンテンスを読み飛ばしているか
+	uint32_t subscribedMask;
+	bool skipSentence;
 
-	// カスタム項目リスト
-	GPSCustom *customElts;
-	GPSCustom *customCandidates;
-	void insertCustom(GPSCustom *pElt, const char *sentenceName, int index);
+	char termBuffer[TERM_BUFFER_LENGTH];
+	uint8_t termLimit;       // 処理中センテンスで termBuffer に溜める最大文字数
+
+	// 登録済みコールバック
+	struct SentenceHandler {
+		SentenceCallback callback;
+		void *context;
+	};
+	struct CommitHandler {
+		uint16_t fields;
+		CommitCallback callback;
+		void *context;
+	};
+	SentenceHandler sentenceHandlers[SentenceType_Count];
+	ChecksumCallback checksumCallback;
+	void *checksumContext;
+	CommitHandler commitHandlers[GPSNMEA_MAX_COMMIT_CALLBACKS];
+	uint8_t commitHandlerCount;
+	// 登録済みコールバックの呼び出し
+	void dispatchCallbacks();
+
+	// 公開中のスナップショット (書き手は encode() 側のみ)
+	GPSSeqLock<GPSSnapshot> snapshotLock;
+
+#if GPSNMEA_INSTRUMENTATION
+	// 計測の状態
+	Stats statsData;
+	bool inSentence;         // '$' を受け取り、チェックサムまで処理し終えていない
+	bool termTruncated;      // 処理中のtermを切り詰めた
+	uint16_t sentenceLength; // 処理中センテンスのバイト数 ('$' 込み)
+	uint32_t timeMark;       // 計測区間の始点 (encode(buf, len) の入口か '$')
+	uint32_t sentenceTicks;  // 処理中センテンスに費やした時間 (前回までの呼び出し分)
+	bool timing;             // encode(buf, len)/decode() の中で、時間を計測中
+	// センテンス外のバイト(garbage)か、センテンス長として数える
+	void statBytes(size_t len) {
+		if (inSentence)
+			sentenceLength = (uint16_t)((sentenceLength + len < 0xFFFF) ? sentenceLength + len : 0xFFFF);
+		else
+			statsData.garbageBytes += len;
+	}
+	void statSentence(bool passed);
+#endif
+
+#if GPSNMEA_UBX
+	// UBXフレームの受信状態
+	enum UbxState {
+		Ubx_Idle,       // フレーム外 (NMEA を処理中)
+		Ubx_Sync,       // 0xB5 を受け取った
+		Ubx_Class,
+		Ubx_Id,
+		Ubx_Length1,
+		Ubx_Length2,
+		Ubx_Payload,
+		Ubx_CkA,
+		Ubx_CkB
+	};
+	// ペイロードを保持する長さ (NAV-PVT の pDOP まで。NAV-SAT は先頭8バイトと衛星1件分)
+	static const int UBX_BUFFER = 84;
+	uint8_t ubxState;
+	uint8_t ubxClass, ubxId;
+	uint16_t ubxLength, ubxOffset;
+	uint8_t ubxCkA, ubxCkB, ubxRecvA;
+	SentenceType ubxType;   // NAV-PVT/NAV-SAT (それ以外のメッセージは Other)
+	uint16_t ubxLastMessage;
+	uint8_t ubxPayload[UBX_BUFFER];
+	// フレーム中のバイトを処理し、消費したバイト数を返す (0 なら同期違い。そのバイトは NMEA として扱う)
+	//  チェックサムまで一致したら frame を true にする
+	size_t ubxBytes(const uint8_t *p, size_t len, bool &frame);
+	void ubxPayloadBytes(const uint8_t *p, size_t n);
+	// ck_b を受け取った時点の照合と commit
+	bool ubxFinish(uint8_t ckB);
+#endif
+
+#if GPSNMEA_RTCM
+	// RTCM3 フレームの組み立て (呼び出しをまたぐフレームのみ。rtcmFill == 0 ならフレーム外)
+	uint16_t rtcmFill;
+	uint8_t rtcmBuffer[GPSNMEA_RTCM_MAX_FRAME];
+	RtcmCallback rtcmCallback;
+	void *rtcmContext;
+	// 0xD3 から始まる len バイトを受け取り、消費したバイト数を返す
+	//  フレーム全体が揃っていればコピーせずに渡す
+	size_t rtcmStart(const uint8_t *p, size_t len);
+	// 組み立て中のフレームへ追加し、消費したバイト数を返す (0 なら同期違い。そのバイトは NMEA として扱う)
+	size_t rtcmBytes(const uint8_t *p, size_t len);
+	// 完結したフレームの CRC を確かめてコールバックへ渡す
+	bool rtcmDeliver(const uint8_t *frame);
+#endif
+
+	// カスタム項目の登録表
+	//  センテンス名のハッシュで引くオープンアドレス表。センテンスごとに
+	//  登録済みtermのビットマップと termNumber 順のリストを持つ
+	struct CustomSentence {
+		const char *name;     // nullptr なら空きスロット
+		uint32_t hash;
+		uint32_t termMask;    // bit n: termNumber n に登録あり (31以上は bit31 にまとめる)
+		GPSCustom *head;
+	};
+	static const int CUSTOM_SLOTS = gpsPow2AtLeast(2 * GPSNMEA_MAX_CUSTOM_SENTENCES);
+	CustomSentence customTable[CUSTOM_SLOTS];
+	uint8_t customSentenceCount;
+	CustomSentence *customSentence;  // 処理中センテンスの登録 (無ければ nullptr)
+	GPSCustom *customCursor;         // 次に照合する登録 (termは昇順に来るので前へ進むだけ)
+
+	static uint32_t hashSentenceName(const char *name, size_t len);
+	CustomSentence *findCustomSentence(const char *name, size_t len);
+	bool insertCustom(GPSCustom *pElt, const char *sentenceName, int index);
+	void clearCustom();
+
+	// 区切り文字($ , * \r \n)の処理
+	bool processDelimiter(char c);
+	// 区切り文字を含まないバイト列をtermBufferへ追加
+	void appendTerm(const char *p, size_t len);
 
 	// term切り出し終わりで呼ばれる内部処理
 	bool endOfTermHandler();
+	// センテンス先頭('$')での状態初期化
+	void beginSentence();
+	// 1term分の処理 (term は NUL終端とは限らない。長さは len)
+	void handleTerm(const char *term, size_t len);
+	// チェックサム照合とcommit。received (受信値) と computed (計算値) が一致すれば true
+	bool finishSentence(uint8_t received, uint8_t computed);
+	// センテンス種類ごとのcommit (スキーマ表の commit を呼ぶ)
+	void commitSentence();
+	// commit済み項目をスナップショットとして公開
+	void publishSnapshot();
 	int fromHex(char a);
 
-	static void parseRMCTerm(int termNumber, const char *term, GPSNMEA &gps);
-	static void parseGGATerm(int termNumber, const char *term, GPSNMEA &gps);
-	static void parseGSATerm(int termNumber, const char *term, GPSNMEA &gps);
-	static void parseGSVTerm(int termNumber, const char *term, GPSNMEA &gps);
-	static void parseVTGTerm(int termNumber, const char *term, GPSNMEA &gps);
+	// GSV 1ページを衛星テーブルへ渡す。サイクルが揃えば true
+	bool commitGSVPage();
 
 	friend class GPSCustom; // カスタムフィールドがcommit/set等を呼ぶ場合
+	friend struct GPSNMEAFields; // センテンスのスキーマ表 (GPSNMEA.cpp) のフィールドパーサ
+	friend struct GPSNMEABenchAccess; // ベンチマーク(bench/)からterm単位のパースを直接計測
 };
 
 #endif // GPSNMEA_HPP
@@ -0,0 +1,128 @@
+#ifndef GPSNMEA_ATOMIC_HPP
+#define GPSNMEA_ATOMIC_HPP
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "GPSNMEAConfig.hpp"
+
+//=================================================================
+// スレッド・割り込み間で共有する値の最小限のアトミック操作
+//  std::atomic がある環境ではそれを使い、無いシングルコアMCUでは
+//  volatile アクセスとコンパイラバリアで同じ順序保証を得る
+//=================================================================
+#if GPSNMEA_USE_STD_ATOMIC
+#include <atomic>
+
+template <class T>
+class GPSAtomic {
+public:
+	GPSAtomic() : v(T()) {}
+
+	T loadRelaxed() const { return v.load(std::memory_order_relaxed); }
+	T loadAcquire() const { return v.load(std::memory_order_acquire); }
+	void storeRelaxed(T x) { v.store(x, std::memory_order_relaxed); }
+	void storeRelease(T x) { v.store(x, std::memory_order_release); }
+
+private:
+	std::atomic<T> v;
+};
+
+inline void gpsFenceAcquire() { std::atomic_thread_fence(std::memory_order_acquire); }
+inline void gpsFenceRelease() { std::atomic_thread_fence(std::memory_order_release); }
+
+// シーケンス番号 (1回の読み書きが分割されない幅)
+typedef uint32_t GPSSequence;
+
+#else
+
+#define GPSNMEA_COMPILER_BARRIER() __asm__ __volatile__("" ::: "memory")
+
+template <class T>
+class GPSAtomic {
+public:
+	GPSAtomic() : v(T()) {}
+
+	T loadRelaxed() const { return v; }
+	T loadAcquire() const { T x = v; GPSNMEA_COMPILER_BARRIER(); return x; }
+	void storeRelaxed(T x) { v = x; }
+	void storeRelease(T x) { GPSNMEA_COMPILER_BARRIER(); v = x; }
+
+private:
+	GPSAtomic(const GPSAtomic &);
+	GPSAtomic &operator=(const GPSAtomic &);
+
+	volatile T v;
+};
+
+inline void gpsFenceAcquire() { GPSNMEA_COMPILER_BARRIER(); }
+inline void gpsFenceRelease() { GPSNMEA_COMPILER_BARRIER(); }
+
+// 8bit MCU では32bitの読み書きが割り込みで分断されるため1バイトにする
+#if defined(__AVR__)
+typedef uint8_t GPSSequence;
+#else
+typedef uint32_t GPSSequence;
+#endif
+
+#endif
+
+//=================================================================
+// シーケンスロック
+//  書き手は1人で待ちなし (wait-free)。読み手はロックを取らず、書き込みと
+//  重なった場合だけ読み直す。T は memcpy でコピーできる型であること
+//=================================================================
+template <class T>
+class GPSSeqLock {
+public:
+	GPSSeqLock() {}
+
+	// 書き手 (encode を呼ぶスレッド / 割り込みハンドラ) から呼ぶ
+	void write(const T &value) {
+		uint32_t tmp[WORDS];
+		memcpy(tmp, &value, sizeof(T));
+		GPSSequence s = seq.loadRelaxed();
+		seq.storeRelaxed(static_cast<GPSSequence>(s + 1));  // 奇数 = 書き込み中
+		gpsFenceRelease();
+		for (size_t i = 0; i < WORDS; ++i)
+			words[i].storeRelaxed(tmp[i]);
+		seq.storeRelease(static_cast<GPSSequence>(s + 2));
+	}
+
+	// 1回だけ読む。書き込みと重なった場合は false
+	//  (書き手より優先度の高い割り込みから読む場合はこちらを使う)
+	bool tryRead(T &out) const {
+		GPSSequence s1 = seq.loadAcquire();
+		if (s1 & 1)
+			return false;
+		uint32_t tmp[WORDS];
+		for (size_t i = 0; i < WORDS; ++i)
+			tmp[i] = words[i].loadRelaxed();
+		gpsFenceAcquire();
+		if (seq.loadRelaxed() != s1)
+			return false;
+		memcpy(&out, tmp, sizeof(T));
+		return true;
+	}
+
+	// 一貫した値が読めるまで読み直す
+	void read(T &out) const {
+		while (!tryRead(out)) {
+		}
+	}
+
+	// 書き込み回数 x2 (書き込み中は奇数)
+	GPSSequence sequence() const { return seq.loadAcquire(); }
+
+private:
+	GPSSeqLock(const GPSSeqLock &);
+	GPSSeqLock &operator=(const GPSSeqLock &);
+
+	static const size_t WORDS = (sizeof(T) + 3) / 4;
+
+	GPSAtomic<GPSSequence> seq;
+	GPSAtomic<uint32_t> words[WORDS];
+};
+
+#endif // GPSNMEA_ATOMIC_HPP
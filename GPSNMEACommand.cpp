@@ -0,0 +1,197 @@
+#include "GPSNMEACommand.hpp"
+
+namespace {
+
+// 種別ごとのコマンド上の識別子
+struct CommandIds {
+	int8_t mtkField;   // PMTK314 の欄 (-1 なら対象外)
+	uint8_t ubxClass;  // CFG-MSG のクラスとID (クラスが0なら対象外)
+	uint8_t ubxId;
+	char name[4];      // PUBX,40 のメッセージ名 (空なら対象外)
+};
+
+const CommandIds kCommandIds[] = {
+	/* Other */  { -1, 0x00, 0x00, "" },
+	/* RMC */    { 1, 0xF0, 0x04, "RMC" },
+	/* GGA */    { 3, 0xF0, 0x00, "GGA" },
+	/* GSA */    { 4, 0xF0, 0x02, "GSA" },
+	/* GSV */    { 5, 0xF0, 0x03, "GSV" },
+	/* VTG */    { 2, 0xF0, 0x05, "VTG" },
+	/* GLL */    { 0, 0xF0, 0x01, "GLL" },
+	/* ZDA */    { 17, 0xF0, 0x08, "ZDA" },
+	/* GST */    { 7, 0xF0, 0x07, "GST" },
+	/* GNS */    { -1, 0xF0, 0x0D, "GNS" },
+	/* GBS */    { -1, 0xF0, 0x09, "GBS" },
+	/* NAVPVT */ { -1, 0x01, 0x07, "" },
+	/* NAVSAT */ { -1, 0x01, 0x35, "" },
+};
+static_assert(sizeof(kCommandIds) / sizeof(kCommandIds[0]) == GPSNMEA::SentenceType_Count,
+	"kCommandIds: one entry per GPSNMEA::SentenceType");
+
+// PMTK314 の欄の数 (GLL, RMC, VTG, GGA, GSA, GSV, GRS, GST, 予約 x9, ZDA, MCHN)
+const int kMtkFields = 19;
+
+char *putUint(char *p, unsigned v) {
+	char tmp[6];
+	int n = 0;
+	do {
+		tmp[n++] = static_cast<char>('0' + v % 10);
+		v /= 10;
+	} while (v != 0);
+	while (n > 0)
+		*p++ = tmp[--n];
+	return p;
+}
+
+char *putText(char *p, const char *s) {
+	while (*s != '\0')
+		*p++ = *s++;
+	return p;
+}
+
+// body ('$' から本文の末尾まで) に "*hh\r\n" を付けて buf へ
+size_t finishNmea(char *buf, size_t size, char *body, char *end) {
+	static const char hex[] = "0123456789ABCDEF";
+	const uint8_t sum = gpsXorBytes(body + 1, static_cast<size_t>(end - body - 1));
+	*end++ = '*';
+	*end++ = hex[sum >> 4];
+	*end++ = hex[sum & 0x0F];
+	*end++ = '\r';
+	*end++ = '\n';
+	const size_t len = static_cast<size_t>(end - body);
+	if (len > size)
+		return 0;
+	memcpy(buf, body, len);
+	return len;
+}
+
+// UBXフレーム (同期文字, クラス, ID, 長さ, ペイロード, チェックサム) を buf へ
+size_t putUbx(uint8_t *buf, size_t size, uint8_t cls, uint8_t id, const uint8_t *payload, uint16_t len) {
+	const size_t total = static_cast<size_t>(len) + 8;
+	if (total > size)
+		return 0;
+	buf[0] = 0xB5;
+	buf[1] = 0x62;
+	buf[2] = cls;
+	buf[3] = id;
+	buf[4] = static_cast<uint8_t>(len & 0xFF);
+	buf[5] = static_cast<uint8_t>(len >> 8);
+	memcpy(buf + 6, payload, len);
+	uint8_t ckA = 0, ckB = 0;
+	gpsUbxChecksum(buf + 2, static_cast<size_t>(len) + 4, ckA, ckB);
+	buf[6 + len] = ckA;
+	buf[7 + len] = ckB;
+	return total;
+}
+
+bool validType(GPSNMEA::SentenceType type) {
+	return static_cast<unsigned>(type) < GPSNMEA::SentenceType_Count;
+}
+
+} // namespace
+
+//-----------------------------------
+// 個別のコマンド
+//-----------------------------------
+size_t gpsPmtkSetOutput(char *buf, size_t size, uint32_t sentences, uint8_t rate) {
+	uint8_t fields[kMtkFields] = {};
+	if (rate > 5)
+		rate = 5;
+	for (int t = 0; t < GPSNMEA::SentenceType_Count; ++t) {
+		if (kCommandIds[t].mtkField >= 0 && (sentences & (1UL << t)))
+			fields[kCommandIds[t].mtkField] = rate;
+	}
+	char body[GPSNMEA_COMMAND_MAX_LENGTH];
+	char *p = putText(body, "$PMTK314");
+	for (int i = 0; i < kMtkFields; ++i) {
+		*p++ = ',';
+		*p++ = static_cast<char>('0' + fields[i]);
+	}
+	return finishNmea(buf, size, body, p);
+}
+
+size_t gpsPmtkSetInterval(char *buf, size_t size, uint16_t intervalMs) {
+	char body[GPSNMEA_COMMAND_MAX_LENGTH];
+	char *p = putText(body, "$PMTK220,");
+	p = putUint(p, intervalMs);
+	return finishNmea(buf, size, body, p);
+}
+
+size_t gpsPubxSetRate(char *buf, size_t size, GPSNMEA::SentenceType type, uint8_t rate) {
+	if (!validType(type) || kCommandIds[type].name[0] == '\0')
+		return 0;
+	// PUBX,40,名前,DDC,UART1,UART2,USB,SPI,予約
+	char body[GPSNMEA_COMMAND_MAX_LENGTH];
+	char *p = putText(body, "$PUBX,40,");
+	p = putText(p, kCommandIds[type].name);
+	for (int port = 0; port < 5; ++port) {
+		*p++ = ',';
+		p = putUint(p, rate);
+	}
+	p = putText(p, ",0");
+	return finishNmea(buf, size, body, p);
+}
+
+size_t gpsUbxSetRate(uint8_t *buf, size_t size, GPSNMEA::SentenceType type, uint8_t rate) {
+	if (!validType(type) || kCommandIds[type].ubxClass == 0)
+		return 0;
+	// CFG-MSG (0x06 0x01) の3バイト版: クラス, ID, コマンドを受けたポートでの出力間隔
+	const uint8_t payload[3] = { kCommandIds[type].ubxClass, kCommandIds[type].ubxId, rate };
+	return putUbx(buf, size, 0x06, 0x01, payload, sizeof(payload));
+}
+
+size_t gpsUbxSetInterval(uint8_t *buf, size_t size, uint16_t intervalMs, uint16_t navRate) {
+	// CFG-RATE (0x06 0x08): measRate, navRate, timeRef (1 = GPS時刻)
+	const uint8_t payload[6] = {
+		static_cast<uint8_t>(intervalMs & 0xFF), static_cast<uint8_t>(intervalMs >> 8),
+		static_cast<uint8_t>(navRate & 0xFF), static_cast<uint8_t>(navRate >> 8),
+		1, 0
+	};
+	return putUbx(buf, size, 0x06, 0x08, payload, sizeof(payload));
+}
+
+//-----------------------------------
+// GPSCommandSequence
+//-----------------------------------
+GPSCommandSequence::GPSCommandSequence(Receiver receiver, uint32_t sentences, uint16_t intervalMs)
+	: receiver(receiver), sentences(sentences), intervalMs(intervalMs), step(0)
+{
+#if !GPSNMEA_UBX
+	this->sentences &= ~(GPSNMEA_SENTENCE_NAVPVT | GPSNMEA_SENTENCE_NAVSAT);
+#endif
+}
+
+size_t GPSCommandSequence::next(uint8_t *buf, size_t size) {
+	char *text = reinterpret_cast<char *>(buf);
+	while (step < GPSNMEA::SentenceType_Count) {
+		if (receiver == Receiver_MTK) {
+			// PMTK314 は1つで全種別
+			size_t n = gpsPmtkSetOutput(text, size, sentences);
+			if (n != 0)
+				step = GPSNMEA::SentenceType_Count;
+			return n;
+		}
+		// u-blox は種別ごとに1コマンド (対象外の種別は飛ばす)
+		const GPSNMEA::SentenceType type = static_cast<GPSNMEA::SentenceType>(step);
+		const uint8_t rate = (sentences & GPSNMEA::sentenceBit(type)) ? 1 : 0;
+		const bool supported = (receiver == Receiver_PUBX) ?
+			kCommandIds[type].name[0] != '\0' : kCommandIds[type].ubxClass != 0;
+		if (!supported) {
+			++step;
+			continue;
+		}
+		size_t n = (receiver == Receiver_PUBX) ?
+			gpsPubxSetRate(text, size, type, rate) : gpsUbxSetRate(buf, size, type, rate);
+		if (n != 0)
+			++step;
+		return n;
+	}
+	if (step == GPSNMEA::SentenceType_Count && intervalMs != 0) {
+		size_t n = (receiver == Receiver_MTK) ?
+			gpsPmtkSetInterval(text, size, intervalMs) : gpsUbxSetInterval(buf, size, intervalMs);
+		if (n != 0)
+			++step;
+		return n;
+	}
+	return 0;
+}
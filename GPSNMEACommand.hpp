@@ -0,0 +1,74 @@
+#ifndef GPSNMEA_COMMAND_HPP
+#define GPSNMEA_COMMAND_HPP
+
+#include "GPSNMEA.hpp"
+
+//=================================================================
+// 受信機への設定コマンドの組み立て
+//  受信機が出力するセンテンスと測位間隔を、アプリケーションがパースする分だけに絞る。
+//  呼び出し側のバッファへ書くだけで、ヒープも使わない。
+//  各関数は書いたバイト数を返す (バッファが足りなければ何も書かずに 0)
+//
+//  応答の確認:
+//    PMTK は "$PMTK001,314,3*hh" などが返る (GPSCustom で "PMTK001" を登録すれば読める)
+//    UBX は ACK-ACK/ACK-NAK が SentenceType_Other として届き、ubxMessage() が 0x0501/0x0500
+//=================================================================
+
+// 1コマンドの最大長 (この大きさのバッファなら全てのコマンドが入る)
+#define GPSNMEA_COMMAND_MAX_LENGTH 64
+
+// MediaTek (PMTK)
+//  PMTK314: sentences (GPSNMEA_SENTENCE_xxx のビット和) の種別を rate 回の測位ごとに出力し、他は止める
+//   (GLL, RMC, VTG, GGA, GSA, GSV, GST, ZDA が対象。rate は 1-5)
+size_t gpsPmtkSetOutput(char *buf, size_t size, uint32_t sentences, uint8_t rate = 1);
+//  PMTK220: 測位間隔 (ミリ秒)
+size_t gpsPmtkSetInterval(char *buf, size_t size, uint16_t intervalMs);
+
+// u-blox (NMEA の PUBX)
+//  PUBX,40: type の出力を rate 回の測位ごと (0 で停止) にする。全ポート共通
+//   (GGA, GLL, GSA, GSV, RMC, VTG, GST, ZDA, GNS, GBS が対象。対象外の種別なら 0 を返す)
+size_t gpsPubxSetRate(char *buf, size_t size, GPSNMEA::SentenceType type, uint8_t rate);
+
+// u-blox (UBX)
+//  CFG-MSG: type の出力を、コマンドを受けたポートで rate 回の測位ごと (0 で停止) にする
+//   (PUBX,40 の対象に加えて NAV-PVT, NAV-SAT)
+size_t gpsUbxSetRate(uint8_t *buf, size_t size, GPSNMEA::SentenceType type, uint8_t rate);
+//  CFG-RATE: 測位間隔 (ミリ秒)。navRate は何回の測位ごとに解を出すか。時刻の基準は GPS時刻
+size_t gpsUbxSetInterval(uint8_t *buf, size_t size, uint16_t intervalMs, uint16_t navRate = 1);
+
+//=================================================================
+// 購読設定から、受信機へ送るコマンド列を順に作る
+//  sentences に含まれる種別を毎回の測位で出力させ、それ以外の対象種別は止める
+//
+//  使い方:
+//    gps.subscribe(GPSNMEA_SENTENCE_RMC | GPSNMEA_SENTENCE_GGA);
+//    GPSCommandSequence seq(GPSCommandSequence::Receiver_MTK, gps.subscription(), 200);
+//    uint8_t buf[GPSNMEA_COMMAND_MAX_LENGTH];
+//    while (size_t n = seq.next(buf, sizeof(buf)))
+//        Serial1.write(buf, n);
+//=================================================================
+class GPSCommandSequence {
+public:
+	enum Receiver {
+		Receiver_MTK,   // PMTK314, PMTK220
+		Receiver_PUBX,  // u-blox: 対象種別ごとの PUBX,40, UBX-CFG-RATE
+		Receiver_UBX    // u-blox: 対象種別ごとの UBX-CFG-MSG (NAV-PVT/NAV-SAT を含む), UBX-CFG-RATE
+	};
+
+	// intervalMs = 0 なら測位間隔のコマンドは作らない
+	//  NAV-PVT/NAV-SAT は GPSNMEA_UBX が 0 なら (パースできないので) 常に止める
+	GPSCommandSequence(Receiver receiver, uint32_t sentences, uint16_t intervalMs = 0);
+
+	// 次のコマンドを buf に書いて長さを返す。全て書き終えたら 0
+	//  buf が足りない場合も 0 (進まないので、大きいバッファで呼び直せる)
+	size_t next(uint8_t *buf, size_t size);
+	void rewind() { step = 0; }
+
+private:
+	Receiver receiver;
+	uint32_t sentences;
+	uint16_t intervalMs;
+	uint8_t step;  // 0 .. SentenceType_Count-1: 種別ごと、SentenceType_Count: 測位間隔
+};
+
+#endif // GPSNMEA_COMMAND_HPP
@@ -0,0 +1,186 @@
+#ifndef GPSNMEA_CONFIG_HPP
+#define GPSNMEA_CONFIG_HPP
+
+//=================================================================
+// ビルド設定
+//  各マクロはコンパイルオプション(-D)で上書き可能
+//=================================================================
+
+// ホストビルド (Linux等、Arduino以外) なら 1
+//  1 の場合は <Arduino.h> の代わりに std::chrono による時計を使う
+#ifndef GPSNMEA_HOST
+#if defined(ARDUINO)
+#define GPSNMEA_HOST 0
+#else
+#define GPSNMEA_HOST 1
+#endif
+#endif
+
+// std::atomic を使うか。0 なら volatile とコンパイラバリアで代用する
+//  (std::atomic の無い AVR など、シングルコアのMCU向け)
+#ifndef GPSNMEA_USE_STD_ATOMIC
+#if defined(__AVR__)
+#define GPSNMEA_USE_STD_ATOMIC 0
+#else
+#define GPSNMEA_USE_STD_ATOMIC 1
+#endif
+#endif
+
+// センテンス種別ごとのビット (GPSNMEA::SentenceType の値 n に対して 1 << n)
+#define GPSNMEA_SENTENCE_OTHER  (1UL << 0)   // 未対応・独自センテンス
+#define GPSNMEA_SENTENCE_RMC    (1UL << 1)
+#define GPSNMEA_SENTENCE_GGA    (1UL << 2)
+#define GPSNMEA_SENTENCE_GSA    (1UL << 3)
+#define GPSNMEA_SENTENCE_GSV    (1UL << 4)
+#define GPSNMEA_SENTENCE_VTG    (1UL << 5)
+#define GPSNMEA_SENTENCE_GLL    (1UL << 6)
+#define GPSNMEA_SENTENCE_ZDA    (1UL << 7)
+#define GPSNMEA_SENTENCE_GST    (1UL << 8)
+#define GPSNMEA_SENTENCE_GNS    (1UL << 9)
+#define GPSNMEA_SENTENCE_GBS    (1UL << 10)
+#define GPSNMEA_SENTENCE_NAVPVT (1UL << 11)  // UBX-NAV-PVT (GPSNMEA_UBX が 1 の時)
+#define GPSNMEA_SENTENCE_NAVSAT (1UL << 12)  // UBX-NAV-SAT (同上)
+#define GPSNMEA_SENTENCE_ALL    0xFFFFFFFFUL
+
+// コンパイル時に有効にするセンテンス (GPSNMEA_SENTENCE_xxx のビット和)
+//  含まれない種別はチェックサム確認のみで読み飛ばし、パース処理はリンクされない
+//  例: -DGPSNMEA_SENTENCES="(GPSNMEA_SENTENCE_RMC|GPSNMEA_SENTENCE_GGA)"
+#ifndef GPSNMEA_SENTENCES
+#define GPSNMEA_SENTENCES GPSNMEA_SENTENCE_ALL
+#endif
+
+// 公開APIから double を取り除くなら 1 (FPU の無い AVR / Cortex-M0 向け)
+//  GPSLocation::lat()/lng()、gsa/vtg の xxxValue() などの double 版と gpsCardinal() が消える
+//  代わりに latE7()/lngE7() と x100 の整数値、gpsCardinalX100() を使う。パース処理は元から整数のみ
+#ifndef GPSNMEA_NO_DOUBLE
+#define GPSNMEA_NO_DOUBLE 0
+#endif
+
+// UBX (u-blox のバイナリプロトコル) のフレームを NMEA と同じバイト列から読むなら 1
+//  0xB5 0x62 で始まるフレームを encode() が検出し、Fletcher チェックサムを確認して
+//  NAV-PVT/NAV-SAT を location, time などへ直接デコードする。0 なら 0xB5 も NMEA の文字として扱う
+//  ペイロードのバッファと pvt で約150バイトを使うので、既定ではホストビルドのみ
+#ifndef GPSNMEA_UBX
+#if GPSNMEA_HOST
+#define GPSNMEA_UBX 1
+#else
+#define GPSNMEA_UBX 0
+#endif
+#endif
+
+// UBXフレームのペイロード長の上限 (バイト)。これより長いヘッダは同期違いとみなして読み捨てる
+//  NAV-SAT は 8 + 衛星数 x12 バイト
+#ifndef GPSNMEA_UBX_MAX_LENGTH
+#define GPSNMEA_UBX_MAX_LENGTH 2048
+#endif
+
+// RTCM3 (補正情報) のフレームを NMEA と同じバイト列から切り出すなら 1
+//  0xD3 で始まるフレームを CRC-24Q で確かめ、GPSNMEA::onRtcm() のコールバックへビューで渡す
+//  呼び出しをまたぐフレームの組み立てに約1KBのバッファを持つので、既定ではホストビルドのみ
+#ifndef GPSNMEA_RTCM
+#if GPSNMEA_HOST
+#define GPSNMEA_RTCM 1
+#else
+#define GPSNMEA_RTCM 0
+#endif
+#endif
+
+// CRC-24Q (gpsCrc24q) で1回に表を引くバイト数 (0, 1, 4, 8)。表は N x 1KB
+//  0 なら表を使わずビット単位で計算する (RAM の少ないMCU向け)
+#ifndef GPSNMEA_CRC24_SLICES
+#if GPSNMEA_HOST
+#define GPSNMEA_CRC24_SLICES 8
+#else
+#define GPSNMEA_CRC24_SLICES 0
+#endif
+#endif
+
+// 2桁の年(yy)の解釈: yy >= GPSNMEA_CENTURY_PIVOT なら 19yy、それ未満なら 20yy
+//  RMC の日付は下2桁しか無いので、1980-2079年を表せる既定値にしている
+#ifndef GPSNMEA_CENTURY_PIVOT
+#define GPSNMEA_CENTURY_PIVOT 80
+#endif
+
+// 1termの最大長 (終端NUL込み)。これを超えるtermは切り詰める (GPSCustom の登録があるセンテンスを除く)
+#ifndef GPSNMEA_MAX_TERM_LENGTH
+#define GPSNMEA_MAX_TERM_LENGTH 20
+#endif
+
+// GPSCustom::value() で取得できるtermの最大長 (終端NUL込み、255以下)。これを超える部分は切り詰める
+//  GPSCustom 1つにつきこの2倍のRAMを使う。ホストビルドの既定値なら NMEA の1センテンス(82文字)に収まる
+//  どのtermも切り詰めずに入る
+#ifndef GPSNMEA_MAX_CUSTOM_LENGTH
+#if GPSNMEA_HOST
+#define GPSNMEA_MAX_CUSTOM_LENGTH 80
+#else
+#define GPSNMEA_MAX_CUSTOM_LENGTH 32
+#endif
+#endif
+
+// GPSCustom を登録できるセンテンス名の数 (1センテンスに登録できるterm数は無制限)
+#ifndef GPSNMEA_MAX_CUSTOM_SENTENCES
+#if GPSNMEA_HOST
+#define GPSNMEA_MAX_CUSTOM_SENTENCES 16
+#else
+#define GPSNMEA_MAX_CUSTOM_SENTENCES 4
+#endif
+#endif
+
+// GSV衛星テーブル(GPSSatelliteTable)に保持できる衛星数 (信号ごとに1件、最大254)
+#ifndef GPSNMEA_MAX_SATELLITES
+#if GPSNMEA_HOST
+#define GPSNMEA_MAX_SATELLITES 128
+#else
+#define GPSNMEA_MAX_SATELLITES 16
+#endif
+#endif
+
+// 衛星テーブル (GPSNMEA::satelliteTable) を持つなら 1。テーブルは衛星数 x約16バイトのRAMを使う
+//  既定では GPSNMEA_SENTENCES に GSV か NAV-SAT (GPSNMEA_UBX が 1 の時) が含まれる場合のみ 1
+#ifndef GPSNMEA_SATELLITE_TABLE
+#if (GPSNMEA_SENTENCES & GPSNMEA_SENTENCE_GSV) || (GPSNMEA_UBX && (GPSNMEA_SENTENCES & GPSNMEA_SENTENCE_NAVSAT))
+#define GPSNMEA_SATELLITE_TABLE 1
+#else
+#define GPSNMEA_SATELLITE_TABLE 0
+#endif
+#endif
+
+// onCommit() で登録できるコールバックの数
+#ifndef GPSNMEA_MAX_COMMIT_CALLBACKS
+#if GPSNMEA_HOST
+#define GPSNMEA_MAX_COMMIT_CALLBACKS 8
+#else
+#define GPSNMEA_MAX_COMMIT_CALLBACKS 4
+#endif
+#endif
+
+// GPSFixLogWriter の書き込みバッファ (バイト)。一杯になるたびに出力コールバックへ渡す
+#ifndef GPSNMEA_FIXLOG_BLOCK_SIZE
+#if GPSNMEA_HOST
+#define GPSNMEA_FIXLOG_BLOCK_SIZE 4096
+#else
+#define GPSNMEA_FIXLOG_BLOCK_SIZE 128
+#endif
+#endif
+
+// パーサの計測 (GPSNMEA::Stats) を組み込むなら 1。0 なら計測コードは一切生成されない
+#ifndef GPSNMEA_INSTRUMENTATION
+#define GPSNMEA_INSTRUMENTATION 0
+#endif
+
+// 計測で「長すぎる」とみなすセンテンス長 ('$' から <CR><LF> まで。NMEA 0183 の上限は82)
+#ifndef GPSNMEA_MAX_SENTENCE_LENGTH
+#define GPSNMEA_MAX_SENTENCE_LENGTH 82
+#endif
+
+// パース時間ヒストグラムのバケット数 (バケット k は [2^k, 2^(k+1)) tick)
+//  tick はホストビルドではナノ秒、Arduino ではマイクロ秒
+#ifndef GPSNMEA_STATS_BUCKETS
+#if GPSNMEA_HOST
+#define GPSNMEA_STATS_BUCKETS 20
+#else
+#define GPSNMEA_STATS_BUCKETS 12
+#endif
+#endif
+
+#endif // GPSNMEA_CONFIG_HPP
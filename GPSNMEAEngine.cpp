@@ -0,0 +1,197 @@
+#include "GPSNMEAEngine.hpp"
+
+#if GPSNMEA_HOST
+
+GPSNMEAEngine::GPSNMEAEngine(uint32_t streamCount, unsigned threads)
+	: fixCallback(nullptr),
+	fixContext(nullptr),
+	queued(0),
+	outstanding(0),
+	stopping(false),
+	steals(0)
+{
+	if (threads == 0)
+		threads = std::thread::hardware_concurrency();
+	if (threads == 0)
+		threads = 1;
+
+	streams.reserve(streamCount);
+	for (uint32_t i = 0; i < streamCount; ++i) {
+		std::unique_ptr<Stream> s(new Stream());
+		s->engine = this;
+		s->id = i;
+		s->scheduled = false;
+		s->bytes = 0;
+		s->sentences = 0;
+		s->fixes = 0;
+		s->gps.onCommit(0xFFFF, onCommit, s.get());
+		streams.push_back(std::move(s));
+	}
+
+	workers.reserve(threads);
+	for (unsigned i = 0; i < threads; ++i)
+		workers.push_back(std::unique_ptr<Worker>(new Worker()));
+	for (unsigned i = 0; i < threads; ++i)
+		workers[i]->thread = std::thread(&GPSNMEAEngine::run, this, i);
+}
+
+GPSNMEAEngine::~GPSNMEAEngine() {
+	wait();
+	{
+		std::lock_guard<std::mutex> lk(idleLock);
+		stopping = true;
+	}
+	idleCv.notify_all();
+	for (size_t i = 0; i < workers.size(); ++i)
+		workers[i]->thread.join();
+}
+
+void GPSNMEAEngine::onFix(FixCallback callback, void *context) {
+	fixCallback = callback;
+	fixContext = context;
+}
+
+bool GPSNMEAEngine::submit(uint32_t stream, const char *data, size_t len) {
+	if (stream >= streams.size())
+		return false;
+	Stream &s = *streams[stream];
+	bool schedule = false;
+	{
+		std::lock_guard<std::mutex> lk(s.lock);
+		s.pending.insert(s.pending.end(), data, data + len);
+		if (!s.scheduled) {
+			s.scheduled = true;
+			schedule = true;
+		}
+	}
+	if (schedule) {
+		{
+			std::lock_guard<std::mutex> lk(idleLock);
+			++outstanding;
+		}
+		// 同じストリームは同じワーカーから始める (キャッシュに残りやすい)
+		enqueue(stream % workers.size(), stream);
+	}
+	return true;
+}
+
+void GPSNMEAEngine::wait() {
+	std::unique_lock<std::mutex> lk(idleLock);
+	doneCv.wait(lk, [this] { return outstanding == 0; });
+}
+
+void GPSNMEAEngine::flush() {
+	for (size_t i = 0; i < streams.size(); ++i) {
+		Stream &s = *streams[i];
+		if (s.epochs.flush())
+			emit(s);
+	}
+}
+
+//-----------------------------------
+// ワーカー
+//-----------------------------------
+void GPSNMEAEngine::enqueue(unsigned worker, uint32_t stream) {
+	{
+		std::lock_guard<std::mutex> lk(workers[worker]->lock);
+		workers[worker]->ready.push_back(stream);
+	}
+	{
+		std::lock_guard<std::mutex> lk(idleLock);
+		queued.fetch_add(1, std::memory_order_relaxed);
+	}
+	idleCv.notify_one();
+}
+
+bool GPSNMEAEngine::take(unsigned index, uint32_t &stream) {
+	// 自分の行列は先頭から (submit 順に近い順で公平に)
+	{
+		Worker &w = *workers[index];
+		std::lock_guard<std::mutex> lk(w.lock);
+		if (!w.ready.empty()) {
+			stream = w.ready.front();
+			w.ready.pop_front();
+			queued.fetch_sub(1, std::memory_order_relaxed);
+			return true;
+		}
+	}
+	// 他のワーカーの行列の末尾から盗む
+	for (size_t k = 1; k < workers.size(); ++k) {
+		Worker &victim = *workers[(index + k) % workers.size()];
+		std::lock_guard<std::mutex> lk(victim.lock);
+		if (!victim.ready.empty()) {
+			stream = victim.ready.back();
+			victim.ready.pop_back();
+			queued.fetch_sub(1, std::memory_order_relaxed);
+			steals.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		}
+	}
+	return false;
+}
+
+void GPSNMEAEngine::run(unsigned index) {
+	for (;;) {
+		uint32_t stream;
+		if (take(index, stream)) {
+			process(index, stream);
+			continue;
+		}
+		std::unique_lock<std::mutex> lk(idleLock);
+		idleCv.wait(lk, [this] { return stopping || queued.load(std::memory_order_relaxed) > 0; });
+		if (stopping && queued.load(std::memory_order_relaxed) == 0)
+			return;
+	}
+}
+
+void GPSNMEAEngine::process(unsigned worker, uint32_t stream) {
+	Stream &s = *streams[stream];
+	{
+		std::lock_guard<std::mutex> lk(s.lock);
+		s.work.swap(s.pending);
+	}
+
+	if (!s.work.empty()) {
+		s.sentences += s.gps.encode(s.work.data(), s.work.size());
+		s.bytes += s.work.size();
+		s.work.clear();
+	}
+
+	bool more;
+	{
+		std::lock_guard<std::mutex> lk(s.lock);
+		more = !s.pending.empty();
+		if (!more)
+			s.scheduled = false;
+	}
+	if (more) {
+		// 処理中に届いた分は同じワーカーの行列の末尾へ戻す (他のストリームを待たせない)
+		enqueue(worker, stream);
+		return;
+	}
+
+	bool done;
+	{
+		std::lock_guard<std::mutex> lk(idleLock);
+		done = --outstanding == 0;
+	}
+	if (done)
+		doneCv.notify_all();
+}
+
+void GPSNMEAEngine::emit(Stream &s) {
+	GPSFix fix;
+	while (s.epochs.read(fix)) {
+		++s.fixes;
+		if (fixCallback != nullptr)
+			fixCallback(s.id, fix, fixContext);
+	}
+}
+
+void GPSNMEAEngine::onCommit(GPSNMEA &gps, uint16_t, void *context) {
+	Stream &s = *static_cast<Stream *>(context);
+	if (s.epochs.add(gps))
+		s.engine->emit(s);
+}
+
+#endif // GPSNMEA_HOST
@@ -0,0 +1,110 @@
+#ifndef GPSNMEA_ENGINE_HPP
+#define GPSNMEA_ENGINE_HPP
+
+#include "GPSNMEA.hpp"
+#include "GPSEpoch.hpp"
+
+#if GPSNMEA_HOST
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//=================================================================
+// 複数受信機のストリームを固定数のワーカーでデコードする (ホストビルド専用)
+//  ストリームごとに GPSNMEA と GPSEpochAssembler を1つずつ持つ。submit() された
+//  バイト列はストリームの待ち行列に積まれ、空いているワーカーが取り出して
+//  GPSNMEA::encode(buf, len) に渡す。1つのストリームを同時に扱うワーカーは
+//  高々1つなので、ストリーム内の順序は submit() の順に保たれる。
+//  ワーカーは自分の待ち行列が空になると他のワーカーの行列の末尾から盗む
+//=================================================================
+class GPSNMEAEngine {
+public:
+	// エポックが閉じるたびにワーカースレッドから呼ばれる
+	typedef void (*FixCallback)(uint32_t stream, const GPSFix &fix, void *context);
+
+	// threads = 0 ならハードウェアスレッド数を使う
+	explicit GPSNMEAEngine(uint32_t streams, unsigned threads = 0);
+	~GPSNMEAEngine();
+
+	// 最初の submit() より前に設定する
+	void onFix(FixCallback callback, void *context = nullptr);
+	// ストリームのデコーダ (subscribe() やコールバック登録用。submit() 後は wait() を挟むこと)
+	//  onRtcm() などのコールバックはワーカースレッドから呼ばれる。ストリームごとに同時には1つだけ
+	//  onFix() の出力はエンジンが各デコーダに登録した onCommit() に依るので、clearCallbacks() や
+	//  removeCommitCallback() でそれを外さないこと (外すとそのストリームの onFix() が止まる)
+	GPSNMEA &decoder(uint32_t stream) { return streams[stream]->gps; }
+
+	// stream に受信バイトを追加する (どのスレッドからでも可)。stream が範囲外なら false
+	bool submit(uint32_t stream, const char *data, size_t len);
+
+	// それまでに submit() された分を全てデコードし終えるまで待つ
+	//  (末尾のエポックは閉じないので、必要なら flush() を呼ぶ)
+	void wait();
+	// 全ストリームの開いているエポックを閉じて onFix() へ渡す (wait() の後に呼ぶ)
+	void flush();
+
+	uint32_t streamCount() const { return static_cast<uint32_t>(streams.size()); }
+	unsigned threadCount() const { return static_cast<unsigned>(workers.size()); }
+
+	// 統計
+	uint64_t bytesDecoded(uint32_t stream) const { return streams[stream]->bytes; }
+	uint64_t sentencesDecoded(uint32_t stream) const { return streams[stream]->sentences; }
+	uint64_t fixCount(uint32_t stream) const { return streams[stream]->fixes; }
+	// 他のワーカーから盗んだ回数
+	uint64_t stealCount() const { return steals.load(std::memory_order_relaxed); }
+
+private:
+	GPSNMEAEngine(const GPSNMEAEngine &);
+	GPSNMEAEngine &operator=(const GPSNMEAEngine &);
+
+	struct Stream {
+		GPSNMEAEngine *engine;
+		uint32_t id;
+		std::mutex lock;
+		std::vector<char> pending;  // 未処理のバイト (lock で保護)
+		bool scheduled;             // ワーカーの行列にある、または処理中 (lock で保護)
+		std::vector<char> work;     // 処理中のバイト (担当ワーカーのみが触る)
+		GPSNMEA gps;
+		GPSEpochAssembler epochs;
+		uint64_t bytes;
+		uint64_t sentences;
+		uint64_t fixes;
+	};
+
+	struct Worker {
+		std::mutex lock;
+		std::deque<uint32_t> ready;  // 処理待ちのストリーム
+		std::thread thread;
+	};
+
+	void run(unsigned index);
+	bool take(unsigned index, uint32_t &stream);
+	void enqueue(unsigned worker, uint32_t stream);
+	void process(unsigned worker, uint32_t stream);
+	void emit(Stream &s);
+	static void onCommit(GPSNMEA &gps, uint16_t fields, void *context);
+
+	std::vector<std::unique_ptr<Stream> > streams;
+	std::vector<std::unique_ptr<Worker> > workers;
+
+	FixCallback fixCallback;
+	void *fixContext;
+
+	// 待機と終了の管理
+	std::mutex idleLock;
+	std::condition_variable idleCv;   // 行列に積まれた
+	std::condition_variable doneCv;   // 全ストリームが処理し終えた
+	std::atomic<size_t> queued;       // 全行列の合計 (増やす時は idleLock を取る)
+	size_t outstanding;               // scheduled なストリーム数 (idleLock で保護)
+	bool stopping;
+	std::atomic<uint64_t> steals;
+};
+
+#endif // GPSNMEA_HOST
+
+#endif // GPSNMEA_ENGINE_HPP
@@ -0,0 +1,205 @@
+#include "GPSNMEAIndex.hpp"
+
+#if GPSNMEA_HOST
+
+#include <stdio.h>
+#include <algorithm>
+
+namespace {
+
+const int64_t kMsPerDay = 86400000LL;
+const int64_t kHalfDayMs = kMsPerDay / 2;
+
+// サイドカーファイルのヘッダ
+//  "GNIX" 版数(4) flags(4) 予約(4) ログの大きさ(8) 件数(8)、以降 key(8) offset(8) の繰り返し
+//  数値はすべてリトルエンディアン
+const char kMagic[4] = { 'G', 'N', 'I', 'X' };
+const uint32_t kVersion = 1;
+const uint32_t kFlagDated = 1;
+const size_t kHeaderSize = 32;
+const size_t kEntrySize = 16;
+
+void put32(unsigned char *p, uint32_t v) {
+	for (int i = 0; i < 4; ++i)
+		p[i] = static_cast<unsigned char>(v >> (8 * i));
+}
+void put64(unsigned char *p, uint64_t v) {
+	for (int i = 0; i < 8; ++i)
+		p[i] = static_cast<unsigned char>(v >> (8 * i));
+}
+uint32_t get32(const unsigned char *p) {
+	uint32_t v = 0;
+	for (int i = 3; i >= 0; --i)
+		v = (v << 8) | p[i];
+	return v;
+}
+uint64_t get64(const unsigned char *p) {
+	uint64_t v = 0;
+	for (int i = 7; i >= 0; --i)
+		v = (v << 8) | p[i];
+	return v;
+}
+
+bool keyLess(const GPSIndexEntry &a, const GPSIndexEntry &b) {
+	return a.key < b.key;
+}
+
+} // namespace
+
+GPSNMEAIndex::GPSNMEAIndex()
+	: sourceSize(0),
+	dated(false)
+{}
+
+int64_t GPSNMEAIndex::makeKey(uint32_t date, uint32_t time) {
+	return gpsEpochMillis(date, time);
+}
+
+int64_t GPSNMEAIndex::makeRelativeKey(int32_t day, uint32_t time) {
+	return day * kMsPerDay + gpsMillisOfDay(time);
+}
+
+size_t GPSNMEAIndex::build(const char *buf, size_t len) {
+	entries.clear();
+	sourceSize = len;
+	dated = false;
+
+	GPSNMEA gps;
+	GPSSentenceReader reader(buf, len);
+	GPSSentenceView s;
+
+	int32_t day = 0;          // 日付が届くまでは先頭日からの相対
+	int64_t lastTod = 0;
+	bool haveTime = false;
+	bool sorted = true;
+
+	while (reader.next(s)) {
+		if (!gps.decode(s))
+			continue;
+		uint16_t fields = gps.committedFields();
+		if (!(fields & GPSNMEA::Field_Time))
+			continue;
+
+		int64_t tod = gps.time.millisOfDay();
+		// 日付なしで時刻が大きく戻ったら0時をまたいだ
+		if (haveTime && tod + kHalfDayMs < lastTod)
+			++day;
+
+		int32_t days;
+		if ((fields & GPSNMEA::Field_Date) && gpsDateToDays(gps.date.value(), days)) {
+			if (!dated) {
+				// それまでの相対日を、最初の日付から逆算した絶対日に直す
+				int64_t shift = (days - day) * kMsPerDay;
+				for (size_t i = 0; i < entries.size(); ++i)
+					entries[i].key += shift;
+				dated = true;
+			}
+			day = days;
+		}
+
+		int64_t key = day * kMsPerDay + tod;
+		if (entries.empty() || key != entries.back().key) {
+			if (!entries.empty() && key < entries.back().key)
+				sorted = false;  // ログの連結などで時刻が戻った
+			GPSIndexEntry e = { key, static_cast<uint64_t>(s.data() - buf) };
+			entries.push_back(e);
+		}
+		lastTod = tod;
+		haveTime = true;
+	}
+
+	if (!sorted)
+		std::stable_sort(entries.begin(), entries.end(), keyLess);
+	return entries.size();
+}
+
+const GPSIndexEntry *GPSNMEAIndex::find(int64_t key) const {
+	if (entries.empty())
+		return nullptr;
+	GPSIndexEntry probe = { key, 0 };
+	std::vector<GPSIndexEntry>::const_iterator it =
+		std::upper_bound(entries.begin(), entries.end(), probe, keyLess);
+	if (it == entries.begin())
+		return &entries.front();
+	return &*(it - 1);
+}
+
+bool GPSNMEAIndex::seek(GPSSentenceReader &reader, int64_t key) const {
+	const GPSIndexEntry *e = find(key);
+	if (e == nullptr)
+		return false;
+	reader.seek(static_cast<size_t>(e->offset));
+	return true;
+}
+
+bool GPSNMEAIndex::save(const char *path) const {
+	FILE *fp = fopen(path, "wb");
+	if (fp == nullptr)
+		return false;
+
+	unsigned char header[kHeaderSize] = {};
+	memcpy(header, kMagic, sizeof(kMagic));
+	put32(header + 4, kVersion);
+	put32(header + 8, dated ? kFlagDated : 0);
+	put64(header + 16, sourceSize);
+	put64(header + 24, entries.size());
+	bool ok = fwrite(header, 1, kHeaderSize, fp) == kHeaderSize;
+
+	unsigned char block[kEntrySize * 256];
+	for (size_t i = 0; ok && i < entries.size(); i += 256) {
+		size_t n = std::min<size_t>(256, entries.size() - i);
+		for (size_t j = 0; j < n; ++j) {
+			put64(block + j * kEntrySize, static_cast<uint64_t>(entries[i + j].key));
+			put64(block + j * kEntrySize + 8, entries[i + j].offset);
+		}
+		ok = fwrite(block, kEntrySize, n, fp) == n;
+	}
+	return fclose(fp) == 0 && ok;
+}
+
+bool GPSNMEAIndex::load(const char *path, uint64_t logSize) {
+	FILE *fp = fopen(path, "rb");
+	if (fp == nullptr)
+		return false;
+
+	unsigned char header[kHeaderSize];
+	bool ok = fread(header, 1, kHeaderSize, fp) == kHeaderSize &&
+		memcmp(header, kMagic, sizeof(kMagic)) == 0 &&
+		get32(header + 4) == kVersion &&
+		(logSize == 0 || get64(header + 16) == logSize);
+
+	std::vector<GPSIndexEntry> loaded;
+	if (ok) {
+		// 件数はファイルに実際に入っている分まで (壊れたヘッダで巨大な確保をしない)
+		uint64_t count = get64(header + 24);
+		long fileSize = -1;
+		if (fseek(fp, 0, SEEK_END) == 0) {
+			fileSize = ftell(fp);
+			if (fseek(fp, static_cast<long>(kHeaderSize), SEEK_SET) != 0)
+				fileSize = -1;
+		}
+		ok = fileSize >= static_cast<long>(kHeaderSize) &&
+			count <= (static_cast<uint64_t>(fileSize) - kHeaderSize) / kEntrySize;
+		if (ok)
+			loaded.resize(static_cast<size_t>(count));
+		unsigned char block[kEntrySize * 256];
+		for (size_t i = 0; ok && i < loaded.size(); i += 256) {
+			size_t n = std::min<size_t>(256, loaded.size() - i);
+			ok = fread(block, kEntrySize, n, fp) == n;
+			for (size_t j = 0; ok && j < n; ++j) {
+				loaded[i + j].key = static_cast<int64_t>(get64(block + j * kEntrySize));
+				loaded[i + j].offset = get64(block + j * kEntrySize + 8);
+			}
+		}
+	}
+	fclose(fp);
+	if (!ok)
+		return false;
+
+	entries.swap(loaded);
+	dated = (get32(header + 8) & kFlagDated) != 0;
+	sourceSize = get64(header + 16);
+	return true;
+}
+
+#endif // GPSNMEA_HOST
@@ -0,0 +1,68 @@
+#ifndef GPSNMEA_INDEX_HPP
+#define GPSNMEA_INDEX_HPP
+
+#include "GPSNMEA.hpp"
+#include "GPSNMEAView.hpp"
+
+#if GPSNMEA_HOST
+
+#include <vector>
+
+//=================================================================
+// NMEAログの時刻索引 (ホストビルド専用)
+//  エポック(UTC時刻が変わった最初のセンテンス)ごとに、時刻キーとファイル位置を記録する。
+//  索引はサイドカーファイル(例: "track.nmea.gnidx")に保存でき、
+//  指定時刻のエポックへ二分探索で移動できる
+//=================================================================
+
+// 索引の1件
+//  key: 1970-01-01 00:00:00 UTC からのミリ秒
+//       RMCの日付が1つも無いログでは、先頭の日を0日目とした経過ミリ秒
+struct GPSIndexEntry {
+	int64_t key;
+	uint64_t offset;   // ログ先頭から '$' までのバイト位置
+};
+
+class GPSNMEAIndex {
+public:
+	GPSNMEAIndex();
+
+	// ログ全体を走査して索引を作り直す。索引の件数を返す
+	//  日付の無いセンテンスは直前の日付を引き継ぎ、時刻が12時間以上戻ったら日付が
+	//  変わったものとみなす (RMCの日付が届けばそちらを優先)。最初の日付より前の
+	//  エポックは、その日付から逆算して埋める
+	size_t build(const char *buf, size_t len);
+
+	// サイドカーファイルへの保存と読み込み
+	//  logSize != 0 なら、索引を作ったログの大きさと一致しない場合に読み込みを失敗させる
+	bool save(const char *path) const;
+	bool load(const char *path, uint64_t logSize = 0);
+
+	size_t size() const { return entries.size(); }
+	const GPSIndexEntry &operator[](size_t i) const { return entries[i]; }
+	// RMCの日付を含むログか (false ならキーは先頭日からの相対)
+	bool hasDate() const { return dated; }
+	// 索引を作ったログの大きさ
+	uint64_t logSize() const { return sourceSize; }
+
+	// key 以前で最も新しいエポック (key が先頭より前なら先頭)。空なら nullptr
+	//  O(log n)
+	const GPSIndexEntry *find(int64_t key) const;
+
+	// find(key) のエポックへ reader を移動する。索引が空なら false
+	bool seek(GPSSentenceReader &reader, int64_t key) const;
+
+	// 日付(ddmmyy)と時刻(hhmmsscc)からキーを作る
+	static int64_t makeKey(uint32_t date, uint32_t time);
+	// 日付の無いログ用: 先頭日からの日数と時刻からキーを作る
+	static int64_t makeRelativeKey(int32_t day, uint32_t time);
+
+private:
+	std::vector<GPSIndexEntry> entries;
+	uint64_t sourceSize;
+	bool dated;
+};
+
+#endif // GPSNMEA_HOST
+
+#endif // GPSNMEA_INDEX_HPP
@@ -0,0 +1,186 @@
+#include "GPSNMEALog.hpp"
+
+#if GPSNMEA_HOST
+
+#include "GPSNMEAView.hpp"
+
+#include <algorithm>
+#include <thread>
+
+namespace {
+
+// p から始まるバイナリフレーム (UBX, RTCM3) の長さ。フレームでなければ 0
+//  GPSNMEA::encode() と同じくヘッダだけで判定する。末尾で切れたフレームは end まで
+size_t binaryFrameLength(const char *p, const char *end) {
+#if GPSNMEA_UBX
+	if (end - p >= 6 && static_cast<uint8_t>(p[0]) == 0xB5 && static_cast<uint8_t>(p[1]) == 0x62) {
+		const size_t n = static_cast<uint8_t>(p[4]) | (static_cast<uint8_t>(p[5]) << 8);
+		if (n <= GPSNMEA_UBX_MAX_LENGTH)
+			return std::min<size_t>(n + 8, end - p);
+	}
+#endif
+#if GPSNMEA_RTCM
+	if (end - p >= 3 && static_cast<uint8_t>(p[0]) == 0xD3) {
+		const int n = gpsRtcmLength(reinterpret_cast<const uint8_t *>(p));
+		if (n >= 0)
+			return std::min<size_t>(static_cast<size_t>(n) + 6, end - p);
+	}
+#endif
+#if !GPSNMEA_UBX && !GPSNMEA_RTCM
+	(void)p;
+	(void)end;
+#endif
+	return 0;
+}
+
+// 次のセンテンス ('$') かバイナリフレームの先頭候補。無ければ end
+const char *findStart(const char *p, const char *end) {
+	const char *next = static_cast<const char *>(memchr(p, '$', end - p));
+	if (next == nullptr)
+		next = end;
+#if GPSNMEA_UBX
+	const char *ubx = static_cast<const char *>(memchr(p, 0xB5, next - p));
+	if (ubx != nullptr)
+		next = ubx;
+#endif
+#if GPSNMEA_RTCM
+	const char *rtcm = static_cast<const char *>(memchr(p, 0xD3, next - p));
+	if (rtcm != nullptr)
+		next = rtcm;
+#endif
+	return next;
+}
+
+// p から始まるセンテンスのチェックサムが合うか (チャンク境界の '$' がフレームの中身でないことの確認)
+bool validSentenceAt(const char *p, const char *end) {
+	const size_t window = 128;
+	GPSSentenceReader reader(p, std::min<size_t>(window, end - p));
+	GPSSentenceView sentence;
+	return reader.next(sentence) && sentence.data() == p && sentence.checksumValid();
+}
+
+} // namespace
+
+GPSNMEALogDecoder::GPSNMEALogDecoder(unsigned threads)
+	: encodedCharCount(0),
+	sentencesWithFixCount(0),
+	failedChecksumCount(0),
+	passedChecksumCount(0),
+	threads(threads)
+{
+	if (this->threads == 0)
+		this->threads = std::thread::hardware_concurrency();
+	if (this->threads == 0)
+		this->threads = 1;
+}
+
+size_t GPSNMEALogDecoder::decode(const char *buf, size_t len, std::vector<GPSDecodedSentence> &out) {
+	// 目安の分割位置から、チェックサムの合うセンテンスの '$' まで進めてチャンク境界とする
+	//  (バイナリフレームの中身の '$' で切ると、フレームが2つのチャンクに分かれてしまう)
+	std::vector<Chunk> chunks(threads);
+	const char *end = buf + len;
+	const char *p = buf;
+	size_t nChunks = 0;
+	for (unsigned i = 0; i < threads && p < end; ++i) {
+		const char *limit = (i + 1 == threads) ? end : buf + len / threads * (i + 1);
+		if (limit < p)
+			limit = p;
+		const char *next = limit;
+		while (next < end) {
+			next = static_cast<const char *>(memchr(next, '$', end - next));
+			if (next == nullptr)
+				next = end;
+			else if (validSentenceAt(next, end))
+				break;
+			else
+				++next;
+		}
+		chunks[nChunks].begin = p;
+		chunks[nChunks].end = next;
+		chunks[nChunks].offset = p - buf;
+		++nChunks;
+		p = next;
+	}
+
+	if (nChunks == 1) {
+		decodeChunk(chunks[0]);
+	} else {
+		std::vector<std::thread> workers;
+		workers.reserve(nChunks - 1);
+		for (size_t i = 1; i < nChunks; ++i)
+			workers.push_back(std::thread(&GPSNMEALogDecoder::decodeChunk, std::ref(chunks[i])));
+		decodeChunk(chunks[0]);
+		for (size_t i = 0; i < workers.size(); ++i)
+			workers[i].join();
+	}
+
+	// 入力順にマージし、統計を合算
+	size_t total = 0;
+	for (size_t i = 0; i < nChunks; ++i)
+		total += chunks[i].sentences.size();
+	out.reserve(out.size() + total);
+	for (size_t i = 0; i < nChunks; ++i) {
+		const Chunk &c = chunks[i];
+		out.insert(out.end(), c.sentences.begin(), c.sentences.end());
+		encodedCharCount += c.gps.encodedCharCount;
+		sentencesWithFixCount += c.gps.sentencesWithFixCount;
+		failedChecksumCount += c.gps.failedChecksumCount;
+		passedChecksumCount += c.gps.passedChecksumCount;
+	}
+	return total;
+}
+
+void GPSNMEALogDecoder::decodeChunk(Chunk &chunk) {
+	GPSNMEA &gps = chunk.gps;
+	const char *p = chunk.begin;
+
+	while (p < chunk.end) {
+		// バイナリフレームは長さの分だけまとめて流す (中身の '$' で切らない)
+		//  UBX はセンテンスと同じく結果を残し、RTCM3 は流すだけ
+		const char *next;
+		bool sentence;
+		const size_t frame = binaryFrameLength(p, chunk.end);
+		if (frame != 0) {
+			next = p + frame;
+			sentence = static_cast<uint8_t>(*p) == 0xB5;
+		} else {
+			next = findStart(p + 1, chunk.end);
+			sentence = (*p == '$');
+		}
+		if (!sentence) {
+			// センテンス外のバイト (ログ先頭のゴミなど) もそのまま流す
+			gps.encode(p, next - p);
+			p = next;
+			continue;
+		}
+
+		GPSDecodedSentence s;
+		memset(&s, 0, sizeof(s));
+		s.offset = chunk.offset + (p - chunk.begin);
+		s.length = static_cast<uint32_t>(next - p);
+		s.checksumValid = gps.encode(p, next - p) != 0;
+		s.type = static_cast<uint8_t>(gps.sentenceType());
+		s.talker = static_cast<uint8_t>(gps.talker());
+		if (s.checksumValid) {
+			// 前のチャンクの状態に依存しないよう、このセンテンスで確定した項目だけを写す
+			uint16_t f = gps.committedFields();
+			s.hasFix = gps.sentenceFix();
+			s.fields = f;
+			if (f & GPSNMEA::Field_Location) {
+				s.lat = gps.location.rawLat();
+				s.lng = gps.location.rawLng();
+			}
+			if (f & GPSNMEA::Field_Time)       s.time = gps.time.value();
+			if (f & GPSNMEA::Field_Date)       s.date = gps.date.value();
+			if (f & GPSNMEA::Field_Speed)      s.speed = gps.speed.value();
+			if (f & GPSNMEA::Field_Course)     s.course = gps.course.value();
+			if (f & GPSNMEA::Field_Altitude)   s.altitude = gps.altitude.value();
+			if (f & GPSNMEA::Field_Hdop)       s.hdop = gps.hdop.value();
+			if (f & GPSNMEA::Field_Satellites) s.satellites = gps.satellites.value();
+		}
+		chunk.sentences.push_back(s);
+		p = next;
+	}
+}
+
+#endif // GPSNMEA_HOST
@@ -0,0 +1,71 @@
+#ifndef GPSNMEA_LOG_HPP
+#define GPSNMEA_LOG_HPP
+
+#include "GPSNMEA.hpp"
+
+#if GPSNMEA_HOST
+
+#include <vector>
+
+//=================================================================
+// 記録済みNMEAログのデコード (ホストビルド専用)
+//=================================================================
+
+// 1センテンス分のデコード結果
+//  fields に立っている項目 (GPSNMEA::Field_xxx) だけがこのセンテンスで確定した値
+struct GPSDecodedSentence {
+	uint64_t offset;        // 入力先頭から '$' (UBX なら 0xB5) までのバイト位置
+	uint32_t length;        // '$' から次の '$'・バイナリフレーム (または入力末尾) までのバイト数。UBX はフレーム長
+	uint8_t type;           // GPSNMEA::SentenceType
+	uint8_t talker;         // GPSNMEA::Talker
+	bool checksumValid;
+	bool hasFix;
+	uint16_t fields;
+
+	RawDegrees lat, lng;
+	uint32_t time;          // hhmmsscc
+	uint32_t date;          // ddmmyy
+	int32_t speed;          // ノット x100
+	int32_t course;         // 度 x100
+	int32_t altitude;       // m x100
+	int32_t hdop;           // x100
+	long satellites;
+};
+
+// ログを '$' 境界でチャンクに分け、チャンクごとに独立した GPSNMEA で並列デコードする。
+// 結果は入力順に並んだセンテンス列として返る。
+// 混在するバイナリフレーム (UBX, RTCM3) はヘッダの長さで切り出し、中身の '$' では切らない。
+// UBX は1フレームを1件の結果とし (type は SentenceType_NAVPVT など)、RTCM3 は GPSNMEA に渡すだけ。
+class GPSNMEALogDecoder {
+public:
+	// threads = 0 ならハードウェアスレッド数を使う
+	explicit GPSNMEALogDecoder(unsigned threads = 0);
+
+	// buf 全体をデコードし、センテンスごとの結果を out に追記する。追記した件数を返す
+	size_t decode(const char *buf, size_t len, std::vector<GPSDecodedSentence> &out);
+
+	unsigned threadCount() const { return threads; }
+
+	// 統計 (全ワーカーの合計、decode() のたびに加算)
+	uint64_t encodedCharCount;
+	uint64_t sentencesWithFixCount;
+	uint64_t failedChecksumCount;
+	uint64_t passedChecksumCount;
+
+private:
+	struct Chunk {
+		const char *begin;
+		const char *end;
+		uint64_t offset;
+		std::vector<GPSDecodedSentence> sentences;
+		GPSNMEA gps;
+	};
+
+	static void decodeChunk(Chunk &chunk);
+
+	unsigned threads;
+};
+
+#endif // GPSNMEA_HOST
+
+#endif // GPSNMEA_LOG_HPP
@@ -1,5 +1,6 @@
 #include <Arduino.h>
 #include "GPSNMEA.hpp"
+#include "GPSNMEACommand.hpp"
 
 // ------------------------------------------------------
 // ハードウェア構成によってはSoftwareSerialを使うことも可能です。
@@ -15,6 +16,25 @@ SoftwareSerial gpsSerial(4, 3); // (RX=4, TX=3) 実際のピンは環境に合
 // GPSNMEAクラスのインスタンス
 GPSNMEA gps;
 
+void printGPSInfo();
+void printFixed(int32_t value, int32_t scale, uint8_t digits);
+
+// 購読しているセンテンスだけを出力するよう受信機を設定する
+//  受信機が余計なセンテンスを送らなければ、受信・チェックサム確認の負荷もその分減る
+//  (u-blox なら Receiver_PUBX か Receiver_UBX)
+void configureGPS(Stream &port) {
+	GPSCommandSequence seq(GPSCommandSequence::Receiver_MTK, gps.subscription(), 1000);
+	uint8_t buf[GPSNMEA_COMMAND_MAX_LENGTH];
+	size_t n;
+	while ((n = seq.next(buf, sizeof(buf))) != 0)
+		port.write(buf, n);
+}
+
+// 位置・時刻がcommitされた時だけ呼ばれる (encode() の中から呼ばれる)
+void onFixCommitted(GPSNMEA &, uint16_t, void *) {
+	printGPSInfo();
+}
+
 void setup() {
 	Serial.begin(115200);     // PCへデバッグ出力用
 
@@ -23,35 +43,50 @@ void setup() {
 	// (UnoやNanoなどハードウェアシリアルが1系統しかない場合)
 #else
 	// ハードウェアSerial1が存在するボード(MegaやLeonardoなど)なら
-	// Serial1.begin(9600);  // 必要に応じて有効化
+	Serial1.begin(9600);      // GPSモジュールの通信速度に合わせる
+#endif
+
+	// 表示に使うのは RMC と GGA だけ
+	//  (受信機への設定コマンドは、上でポートを開いた後に送る)
+	gps.subscribe(GPSNMEA_SENTENCE_RMC | GPSNMEA_SENTENCE_GGA);
+#if defined(ARDUINO_AVR_UNO) || defined(ARDUINO_AVR_NANO)
+	configureGPS(gpsSerial);
+#else
+	configureGPS(Serial1);
 #endif
 
+	// RMC/GGA で位置か時刻がcommitされたら表示する
+	//  (encode() の戻り値を見て全項目の isUpdated() を調べる必要はない)
+	gps.onCommit(GPSNMEA::Field_Location | GPSNMEA::Field_Time, onFixCommitted);
+
 	// 初期化メッセージ
 	Serial.println("GPSNMEA Test Start");
 }
 
+// 受信済みのバイトをまとめて読み出し、GPSNMEA::encode(buf, len) に渡す
+//  1文字ずつ encode() を呼ぶより速く、高レート出力でも取りこぼしにくい
+//  (UART割り込みで自前に受信する場合は GPSByteRing に push() し、ここで drain() する)
+void readGPS(Stream &port) {
+	char buf[64];
+	int n;
+	while ((n = port.available()) > 0) {
+		if (n > (int)sizeof(buf))
+			n = sizeof(buf);
+		n = port.readBytes(buf, n);
+		gps.encode(buf, n);  // 表示は onFixCommitted から
+	}
+}
+
 void loop() {
 	// ------------------------------------------------------
 	// 1) GPSから受信して GPSNMEA::encode() に渡す
 	// ------------------------------------------------------
 #if defined(ARDUINO_AVR_UNO) || defined(ARDUINO_AVR_NANO)
 	// SoftwareSerialでの読み取り
-	while (gpsSerial.available() > 0) {
-		char c = gpsSerial.read();
-		// GPSNMEAのencodeに1文字ずつ渡す
-		if (gps.encode(c)) {
-			// 1文(センテンス)の解析が完了したらtrueが返る
-			printGPSInfo();
-		}
-	}
+	readGPS(gpsSerial);
 #else
 	// 例: MegaやLeonardo等でSerial1をGPSに接続している場合
-	while (Serial1.available() > 0) {
-		char c = Serial1.read();
-		if (gps.encode(c)) {
-			printGPSInfo();
-		}
-	}
+	readGPS(Serial1);
 #endif
 }
 
@@ -60,13 +95,12 @@ void loop() {
 // ------------------------------------------------------
 void printGPSInfo() {
 	// 位置情報
+	//  latE7()/lngE7() は 1e-7度単位の整数。FPUの無いボードでも double への変換が要らない
 	if (gps.location.isValid()) {
-		double lat = gps.location.lat();
-		double lng = gps.location.lng();
 		Serial.print("Lat: ");
-		Serial.print(lat, 6);
+		printFixed(gps.location.latE7(), 10000000L, 7);
 		Serial.print("  Lng: ");
-		Serial.print(lng, 6);
+		printFixed(gps.location.lngE7(), 10000000L, 7);
 	} else {
 		Serial.print("Lat: ---  Lng: ---");
 	}
@@ -99,29 +133,27 @@ void printGPSInfo() {
 	}
 	if (gps.hdop.isValid()) {
 		Serial.print("  HDOP: ");
-		Serial.print(gps.hdop.value() / 100.0, 2); // gpsParseDecimal()は100倍の値
+		printFixed(gps.hdop.value(), 100, 2); // gpsParseDecimal()は100倍の値
 	}
 	if (gps.altitude.isValid()) {
 		Serial.print("  Alt: ");
-		Serial.print(gps.altitude.value() / 100.0, 2);
+		printFixed(gps.altitude.value(), 100, 2);
 		Serial.print("m");
 	}
 
 	// 移動速度 (RMC文より)
 	if (gps.speed.isValid()) {
 		// speed.value()は "ノット" を100倍した値
-		double speedKnots = gps.speed.value() / 100.0;
-		// 例: ノット→km/hに変換
-		double speedKmh = speedKnots * 1.852;
+		// 例: ノット→km/hに変換 (1ノット = 1.852km/h。x100のまま整数で計算)
+		int32_t speedKmh = (gps.speed.value() * 1852L + 500) / 1000;
 		Serial.print("  Speed: ");
-		Serial.print(speedKmh, 2);
+		printFixed(speedKmh, 100, 2);
 		Serial.print(" km/h");
 	}
 
 	// 進行方向 (course) → 16方位へ
 	if (gps.course.isValid()) {
-		double courseDeg = gps.course.value() / 100.0; // 度
-		const char* direction = gpsCardinal(courseDeg);
+		const char* direction = gpsCardinalX100(gps.course.value()); // 度 x100
 		Serial.print("  Dir: ");
 		Serial.print(direction);
 	}
@@ -130,3 +162,17 @@ void printGPSInfo() {
 	Serial.println();
 }
 
+// 固定小数点の整数 (value / scale) を小数点以下 digits 桁で表示する
+void printFixed(int32_t value, int32_t scale, uint8_t digits) {
+	if (value < 0) {
+		Serial.print("-");
+		value = -value;
+	}
+	Serial.print(value / scale);
+	Serial.print(".");
+	int32_t frac = value % scale;
+	for (int32_t d = scale / 10; d > 0 && digits > 0; d /= 10, --digits) {
+		Serial.print((int)(frac / d));
+		frac %= d;
+	}
+}
@@ -0,0 +1,131 @@
+#include "GPSNMEAView.hpp"
+#include <ctype.h>
+
+#if GPSNMEA_HAS_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//=================================================================
+// GPSSentenceView
+//=================================================================
+GPSSentenceView::GPSSentenceView()
+	: ptr(nullptr), len(0), bodyLen(0), checksumPresent(false)
+{}
+
+GPSSentenceView::GPSSentenceView(const char *sentence, size_t length)
+	: ptr(sentence), len(length), bodyLen(0), checksumPresent(false)
+{
+	if (len == 0)
+		return;
+	const char *star = static_cast<const char *>(memchr(ptr + 1, '*', len - 1));
+	if (star == nullptr) {
+		bodyLen = len - 1;
+		return;
+	}
+	bodyLen = static_cast<size_t>(star - (ptr + 1));
+	checksumPresent = (ptr + len - star) >= 3 &&
+		isxdigit(static_cast<unsigned char>(star[1])) &&
+		isxdigit(static_cast<unsigned char>(star[2]));
+}
+
+uint8_t GPSSentenceView::checksum() const {
+	const char *star = ptr + 1 + bodyLen;
+	return static_cast<uint8_t>(16 * gpsFromHex(star[1]) + gpsFromHex(star[2]));
+}
+
+uint8_t GPSSentenceView::computeChecksum() const {
+	return gpsXorBytes(body(), bodyLen);
+}
+
+bool GPSSentenceView::nextTerm(GPSTermView &term) const {
+	const char *bodyEnd = body() + bodyLen;
+	const char *start;
+	if (term.data == nullptr) {
+		if (len == 0)
+			return false;
+		start = body();
+	} else {
+		start = term.data + term.length;
+		if (start >= bodyEnd)
+			return false;
+		++start;  // ',' を飛ばす
+	}
+	const char *comma = static_cast<const char *>(memchr(start, ',', bodyEnd - start));
+	term.data = start;
+	term.length = static_cast<size_t>((comma != nullptr ? comma : bodyEnd) - start);
+	return true;
+}
+
+//=================================================================
+// GPSSentenceReader
+//=================================================================
+GPSSentenceReader::GPSSentenceReader(const char *buf, size_t len)
+	: begin(buf), cur(buf), end(buf + len)
+{}
+
+void GPSSentenceReader::seek(size_t offset) {
+	cur = (offset < static_cast<size_t>(end - begin)) ? begin + offset : end;
+}
+
+bool GPSSentenceReader::next(GPSSentenceView &sentence) {
+	const char *start = static_cast<const char *>(memchr(cur, '$', end - cur));
+	if (start == nullptr) {
+		cur = end;
+		return false;
+	}
+	// 次の '$' / CR / LF までがこのセンテンス (',' '*' は読み飛ばす)
+	const char *p = start + 1;
+	for (;;) {
+		p = gpsFindDelimiter(p, end);
+		if (p == end || *p == '$' || *p == '\r' || *p == '\n')
+			break;
+		++p;
+	}
+	sentence = GPSSentenceView(start, static_cast<size_t>(p - start));
+	cur = p;
+	return true;
+}
+
+//=================================================================
+// GPSNMEAFile
+//=================================================================
+#if GPSNMEA_HAS_MMAP
+GPSNMEAFile::GPSNMEAFile()
+	: mapping(nullptr), mappedSize(0)
+{}
+
+GPSNMEAFile::~GPSNMEAFile() {
+	close();
+}
+
+bool GPSNMEAFile::open(const char *path) {
+	close();
+	int fd = ::open(path, O_RDONLY);
+	if (fd < 0)
+		return false;
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+		::close(fd);
+		return false;
+	}
+	void *p = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	::close(fd);  // マッピングはfdを閉じても残る
+	if (p == MAP_FAILED)
+		return false;
+	madvise(p, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+	mapping = p;
+	mappedSize = static_cast<size_t>(st.st_size);
+	return true;
+}
+
+void GPSNMEAFile::close() {
+	if (mapping != nullptr) {
+		munmap(mapping, mappedSize);
+		mapping = nullptr;
+		mappedSize = 0;
+	}
+}
+#endif
@@ -0,0 +1,92 @@
+#ifndef GPSNMEA_VIEW_HPP
+#define GPSNMEA_VIEW_HPP
+
+#include "GPSNMEA.hpp"
+
+//=================================================================
+// ゼロコピーのセンテンス/termビュー
+//  入力バッファ(mmapしたログなど)を指すポインタと長さだけを持ち、コピーや確保をしない
+//=================================================================
+
+// 1term分のビュー (',' '*' で終わり、NUL終端ではない)
+struct GPSTermView {
+	const char *data;
+	size_t length;
+};
+
+// '$' から CR/LF の手前までの1センテンス分のビュー
+class GPSSentenceView {
+public:
+	GPSSentenceView();
+	GPSSentenceView(const char *sentence, size_t length);
+
+	const char *data() const { return ptr; }
+	size_t length() const { return len; }
+
+	// '$' と '*' の間 (チェックサム計算対象)
+	const char *body() const { return ptr + 1; }
+	size_t bodyLength() const { return bodyLen; }
+
+	// '*' の後に16進2桁があるか
+	bool hasChecksum() const { return checksumPresent; }
+	// センテンスに書かれているチェックサム値
+	uint8_t checksum() const;
+	// 本文から計算したチェックサム値 (その場でXOR)
+	uint8_t computeChecksum() const;
+	bool checksumValid() const { return checksumPresent && checksum() == computeChecksum(); }
+
+	// termを順に取り出す。term.data == nullptr で呼ぶと先頭(センテンス名)から
+	bool nextTerm(GPSTermView &term) const;
+
+private:
+	const char *ptr;
+	size_t len;
+	size_t bodyLen;
+	bool checksumPresent;
+};
+
+// バッファからセンテンスビューを順に切り出す
+class GPSSentenceReader {
+public:
+	GPSSentenceReader(const char *buf, size_t len);
+
+	// 次のセンテンスを sentence に設定する。無ければ false
+	bool next(GPSSentenceView &sentence);
+
+	// 次に読む位置 (バッファ先頭からのバイト数)
+	size_t position() const { return static_cast<size_t>(cur - begin); }
+	void seek(size_t offset);
+
+private:
+	const char *begin;
+	const char *cur;
+	const char *end;
+};
+
+#if GPSNMEA_HOST && (defined(__unix__) || defined(__APPLE__))
+#define GPSNMEA_HAS_MMAP 1
+
+// 読み取り専用でmmapしたログファイル (ホストビルド専用)
+class GPSNMEAFile {
+public:
+	GPSNMEAFile();
+	~GPSNMEAFile();
+
+	bool open(const char *path);
+	void close();
+	bool isOpen() const { return mapping != nullptr; }
+
+	const char *data() const { return static_cast<const char *>(mapping); }
+	size_t size() const { return mappedSize; }
+	GPSSentenceReader reader() const { return GPSSentenceReader(data(), size()); }
+
+private:
+	GPSNMEAFile(const GPSNMEAFile &);
+	GPSNMEAFile &operator=(const GPSNMEAFile &);
+
+	void *mapping;
+	size_t mappedSize;
+};
+#endif
+
+#endif // GPSNMEA_VIEW_HPP
@@ -0,0 +1,95 @@
+#include "GPSRtcm.hpp"
+
+static_assert(GPSNMEA_CRC24_SLICES == 0 || GPSNMEA_CRC24_SLICES == 1 ||
+	GPSNMEA_CRC24_SLICES == 4 || GPSNMEA_CRC24_SLICES == 8,
+	"GPSNMEA_CRC24_SLICES must be 0, 1, 4 or 8");
+
+namespace {
+
+// CRC は32bitレジスタの上位24bitで計算する (下位8bitは常に0)。
+//  こうすると CRC-32 の MSB-first と同じ形で、4/8バイトをまとめて表引きできる
+const uint32_t kCrc24Poly = 0x864CFB00UL;  // 0x1864CFB の x^24 を除き8bit左へ
+
+#if GPSNMEA_CRC24_SLICES > 0
+// t[k][b]: バイト b の後に 0 が k バイト続いた場合の CRC
+struct Crc24Table {
+	uint32_t t[GPSNMEA_CRC24_SLICES][256];
+
+	Crc24Table() {
+		for (uint32_t b = 0; b < 256; ++b) {
+			uint32_t r = b << 24;
+			for (int i = 0; i < 8; ++i)
+				r = (r & 0x80000000UL) ? (r << 1) ^ kCrc24Poly : (r << 1);
+			t[0][b] = r;
+		}
+		for (int k = 1; k < GPSNMEA_CRC24_SLICES; ++k) {
+			for (uint32_t b = 0; b < 256; ++b)
+				t[k][b] = (t[k - 1][b] << 8) ^ t[0][t[k - 1][b] >> 24];
+		}
+	}
+};
+
+// 最初の呼び出しで1回だけ作る (C++11 の静的局所変数なので複数スレッドからでも安全)
+const Crc24Table &crc24Table() {
+	static const Crc24Table table;
+	return table;
+}
+
+#if GPSNMEA_CRC24_SLICES >= 4
+inline uint32_t loadBE32(const uint8_t *p) {
+	return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+		(static_cast<uint32_t>(p[2]) << 8) | p[3];
+}
+#endif
+#endif
+
+} // namespace
+
+uint32_t gpsCrc24q(const uint8_t *p, size_t len, uint32_t crc) {
+	uint32_t r = crc << 8;
+#if GPSNMEA_CRC24_SLICES == 0
+	// 表を使わずビット単位で (RAM の少ないMCU向け)
+	while (len--) {
+		r ^= static_cast<uint32_t>(*p++) << 24;
+		for (int i = 0; i < 8; ++i)
+			r = (r & 0x80000000UL) ? (r << 1) ^ kCrc24Poly : (r << 1);
+	}
+#else
+	const uint32_t (*t)[256] = crc24Table().t;
+#if GPSNMEA_CRC24_SLICES == 8
+	// slice-by-8: 8バイトを8つの表の独立した参照で処理する
+	while (len >= 8) {
+		const uint32_t a = r ^ loadBE32(p);
+		const uint32_t b = loadBE32(p + 4);
+		r = t[7][a >> 24] ^ t[6][(a >> 16) & 0xFF] ^ t[5][(a >> 8) & 0xFF] ^ t[4][a & 0xFF] ^
+			t[3][b >> 24] ^ t[2][(b >> 16) & 0xFF] ^ t[1][(b >> 8) & 0xFF] ^ t[0][b & 0xFF];
+		p += 8;
+		len -= 8;
+	}
+#elif GPSNMEA_CRC24_SLICES == 4
+	while (len >= 4) {
+		const uint32_t a = r ^ loadBE32(p);
+		r = t[3][a >> 24] ^ t[2][(a >> 16) & 0xFF] ^ t[1][(a >> 8) & 0xFF] ^ t[0][a & 0xFF];
+		p += 4;
+		len -= 4;
+	}
+#endif
+	while (len--)
+		r = (r << 8) ^ t[0][(r >> 24) ^ *p++];
+#endif
+	return r >> 8;
+}
+
+bool gpsRtcmCheck(const uint8_t *frame, GPSRtcmFrame &view) {
+	const int n = gpsRtcmLength(frame);
+	if (n < 0)
+		return false;
+	const uint8_t *c = frame + 3 + n;
+	const uint32_t received = (static_cast<uint32_t>(c[0]) << 16) | (static_cast<uint32_t>(c[1]) << 8) | c[2];
+	if (gpsCrc24q(frame, 3 + n) != received)
+		return false;
+	view.data = frame;
+	view.length = static_cast<uint16_t>(n);
+	view.messageType = (n >= 2) ? static_cast<uint16_t>((frame[3] << 4) | (frame[4] >> 4)) : 0;
+	return true;
+}
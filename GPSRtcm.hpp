@@ -0,0 +1,36 @@
+#ifndef GPS_RTCM_HPP
+#define GPS_RTCM_HPP
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "GPSNMEAConfig.hpp"
+
+// RTCM3 フレームの最大長 (0xD3, 長さ2バイト, ペイロード最大1023, CRC 3バイト)
+#define GPSNMEA_RTCM_MAX_FRAME (3 + 1023 + 3)
+
+// CRC-24Q (RTCM3/SBAS の CRC。多項式 0x1864CFB、初期値0)
+//  crc に続きから加算する。GPSNMEA_CRC24_SLICES バイトずつ表を引く
+uint32_t gpsCrc24q(const uint8_t *p, size_t len, uint32_t crc = 0);
+
+// RTCM3 フレーム1つ分のビュー (0xD3 から CRC の末尾まで。コピーも所有もしない)
+struct GPSRtcmFrame {
+	const uint8_t *data;
+	uint16_t length;       // ペイロード長 (0-1023)
+	uint16_t messageType;  // ペイロード先頭の12bit (1005, 1077 など。ペイロードが2バイト未満なら0)
+
+	const uint8_t *payload() const { return data + 3; }
+	size_t size() const { return static_cast<size_t>(length) + 6; }
+};
+
+// 先頭3バイトからペイロード長を返す。0xD3 で始まり予約bit(6bit)が0でなければ -1
+inline int gpsRtcmLength(const uint8_t *header) {
+	if (header[0] != 0xD3 || (header[1] & 0xFC) != 0)
+		return -1;
+	return ((header[1] & 0x03) << 8) | header[2];
+}
+
+// frame (ヘッダの長さ + 6 バイト以上あること) の CRC を確かめ、一致すれば view を設定して true
+bool gpsRtcmCheck(const uint8_t *frame, GPSRtcmFrame &view);
+
+#endif // GPS_RTCM_HPP
@@ -0,0 +1,137 @@
+#include "GPSSatelliteTable.hpp"
+#include "GPSNMEA.hpp"
+
+static_assert(GPSSatelliteTable::CAPACITY < 0xFF, "GPSNMEA_MAX_SATELLITES must be below 255");
+
+GPSSatelliteTable::GPSSatelliteTable()
+	: publishedCount(0), stagingCount(0), stagingTalker(0), stagingSignal(0),
+	stagingTotal(0), stagingNext(0), stagingAll(false), cycles(0), overflows(0),
+	valid(false), updated(false), lastCommitTime(0)
+{
+	memset(index, EMPTY, sizeof(index));
+}
+
+void GPSSatelliteTable::clear() {
+	publishedCount = 0;
+	stagingCount = 0;
+	stagingNext = 0;
+	stagingAll = false;
+	cycles = 0;
+	overflows = 0;
+	valid = false;
+	updated = false;
+	memset(index, EMPTY, sizeof(index));
+}
+
+const GPSSatellite *GPSSatelliteTable::find(uint16_t prn, uint8_t talker) const {
+	// 線形探査。同じPRNの別衛星系・別信号も同じ連鎖に並ぶ
+	for (unsigned slot = indexSlot(prn); index[slot] != EMPTY; slot = (slot + 1) & (INDEX_SIZE - 1)) {
+		const GPSSatellite &s = published[index[slot]];
+		if (s.prn == prn && (talker == 0 || s.talker == talker))
+			return &s;
+	}
+	return nullptr;
+}
+
+size_t GPSSatelliteTable::countOf(uint8_t talker, uint8_t signalId) const {
+	size_t n = 0;
+	for (size_t i = 0; i < publishedCount; ++i) {
+		if (published[i].talker == talker && (signalId == 0xFF || published[i].signalId == signalId))
+			++n;
+	}
+	return n;
+}
+
+bool GPSSatelliteTable::addPage(uint8_t talker, uint8_t signalId, int totalMessages, int messageNumber,
+	const GPSSatellite *sats, int n)
+{
+	if (messageNumber == 1) {
+		// 新しいサイクルの開始
+		stagingTalker = talker;
+		stagingSignal = signalId;
+		stagingTotal = totalMessages;
+		stagingCount = 0;
+		stagingNext = 1;
+		stagingAll = false;
+	}
+	// ページの抜け・順序違い・別サイクルの混入はサイクルごと捨てる
+	if (stagingNext == 0 || messageNumber != stagingNext || totalMessages != stagingTotal ||
+		talker != stagingTalker || signalId != stagingSignal)
+	{
+		stagingNext = 0;
+		return false;
+	}
+
+	for (int i = 0; i < n; ++i) {
+		if (stagingCount < static_cast<size_t>(CAPACITY))
+			staging[stagingCount++] = sats[i];
+		else
+			++overflows;
+	}
+
+	if (messageNumber < totalMessages) {
+		++stagingNext;
+		return false;
+	}
+	stagingNext = 0;
+	publish();
+	return true;
+}
+
+void GPSSatelliteTable::beginAll() {
+	stagingCount = 0;
+	stagingNext = 0;
+	stagingAll = true;
+}
+
+void GPSSatelliteTable::stage(const GPSSatellite &sat) {
+	if (!stagingAll)
+		return;
+	if (stagingCount < static_cast<size_t>(CAPACITY))
+		staging[stagingCount++] = sat;
+	else
+		++overflows;
+}
+
+bool GPSSatelliteTable::publishAll() {
+	if (!stagingAll)
+		return false;  // 途中で GSV のサイクルが始まった
+	publish();
+	stagingAll = false;
+	return true;
+}
+
+void GPSSatelliteTable::publish() {
+	// 同じ衛星系・信号の古いエントリを詰めて除き、新しいサイクルを追加
+	//  (beginAll() のサイクルなら全て置き換える)
+	size_t kept = 0;
+	for (size_t i = 0; i < publishedCount && !stagingAll; ++i) {
+		const GPSSatellite &s = published[i];
+		if (s.talker == stagingTalker && s.signalId == stagingSignal)
+			continue;
+		published[kept++] = s;
+	}
+	for (size_t i = 0; i < stagingCount; ++i) {
+		if (kept < static_cast<size_t>(CAPACITY))
+			published[kept++] = staging[i];
+		else
+			++overflows;
+	}
+	publishedCount = kept;
+	rebuildIndex();
+
+	++cycles;
+	valid = true;
+	updated = true;
+	lastCommitTime = gpsMillis();
+}
+
+void GPSSatelliteTable::rebuildIndex() {
+	memset(index, EMPTY, sizeof(index));
+	for (size_t i = 0; i < publishedCount; ++i) {
+		unsigned slot = indexSlot(published[i].prn);
+		while (index[slot] != EMPTY)
+			slot = (slot + 1) & (INDEX_SIZE - 1);
+		index[slot] = static_cast<uint8_t>(i);
+	}
+}
@@ -0,0 +1,89 @@
+#ifndef GPS_SATELLITE_TABLE_HPP
+#define GPS_SATELLITE_TABLE_HPP
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "GPSNMEAConfig.hpp"
+
+// 衛星1機(1信号)分の情報
+struct GPSSatellite {
+	uint16_t prn;
+	uint16_t azimuth;     // 度 (0-359)
+	int8_t elevation;     // 度 (-90-90)
+	uint8_t snr;          // dB-Hz (0 = 未追尾)
+	uint8_t talker;       // GPSNMEA::Talker
+	uint8_t signalId;     // NMEA 4.10 の signal ID (0 = 出力なし)
+};
+
+//=================================================================
+// 全衛星系・全ページ分のGSV衛星テーブル
+//  GSVの1サイクル(totalMessages ページ)が揃った時点で、その衛星系・信号の
+//  エントリをまとめて置き換える。途中のページは公開側に見えない。
+//  固定容量でヒープを使わず、PRNからの検索はハッシュ索引で O(1)
+//=================================================================
+class GPSSatelliteTable {
+public:
+	static const int CAPACITY = GPSNMEA_MAX_SATELLITES;
+
+	GPSSatelliteTable();
+	void clear();
+
+	size_t count() const { return publishedCount; }
+	const GPSSatellite &operator[](size_t i) const { return published[i]; }
+
+	// PRNで検索。talker = 0 (Talker_Unknown) なら衛星系を問わず最初に見つかったもの
+	const GPSSatellite *find(uint16_t prn, uint8_t talker = 0) const;
+
+	// 指定した衛星系(と信号)の衛星数。signalId = 0xFF なら全信号
+	size_t countOf(uint8_t talker, uint8_t signalId = 0xFF) const;
+
+	// サイクルが完結して公開された回数
+	uint32_t cycleCount() const { return cycles; }
+	// 容量不足で捨てた衛星数
+	uint32_t overflowCount() const { return overflows; }
+
+	bool isValid() const { return valid; }
+	bool isUpdated() const { return updated; }
+	void clearUpdated() { updated = false; }
+
+	// GSV 1ページ分を取り込む。サイクルが揃って公開したら true
+	bool addPage(uint8_t talker, uint8_t signalId, int totalMessages, int messageNumber,
+		const GPSSatellite *sats, int n);
+
+	// 全衛星系を1回でまとめて置き換えるサイクル (UBX-NAV-SAT 用)
+	//  beginAll() で組み立て中の GSV サイクルは捨てる。publishAll() で公開したら true
+	void beginAll();
+	void stage(const GPSSatellite &sat);
+	bool publishAll();
+
+private:
+	// 索引はCAPACITYの2倍以上の2のべき
+	static const int INDEX_SIZE =
+		CAPACITY <= 16 ? 32 : CAPACITY <= 32 ? 64 : CAPACITY <= 64 ? 128 : 256 * ((CAPACITY + 127) / 128);
+	static const uint8_t EMPTY = 0xFF;
+
+	static unsigned indexSlot(uint16_t prn) { return (prn * 37u) & (INDEX_SIZE - 1); }
+	void publish();
+	void rebuildIndex();
+
+	GPSSatellite published[CAPACITY];
+	size_t publishedCount;
+	uint8_t index[INDEX_SIZE];
+
+	// 組み立て中のサイクル
+	GPSSatellite staging[CAPACITY];
+	size_t stagingCount;
+	uint8_t stagingTalker;
+	uint8_t stagingSignal;
+	int stagingTotal;
+	int stagingNext;       // 次に来るべきページ番号 (0 = 組み立て中でない)
+	bool stagingAll;       // beginAll() のサイクル (公開時に全エントリを置き換える)
+
+	uint32_t cycles;
+	uint32_t overflows;
+	bool valid, updated;
+	unsigned long lastCommitTime;
+};
+
+#endif // GPS_SATELLITE_TABLE_HPP
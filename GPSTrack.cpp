@@ -0,0 +1,250 @@
+#include "GPSTrack.hpp"
+
+#if GPSNMEA_HOST
+
+#include <stdlib.h>
+#include <string.h>
+
+namespace {
+
+// 各列の先頭をキャッシュライン境界に揃える
+const size_t kAlign = 64;
+
+uintptr_t alignUp(uintptr_t n) {
+	return (n + kAlign - 1) & ~(kAlign - 1);
+}
+
+const char kMagic[4] = { 'G', 'T', 'R', 'K' };
+const uint32_t kVersion = 1;
+
+// 符号付き固定小数点を "整数部.小数部" で書く
+char *putFixed(char *p, int64_t v, unsigned digits) {
+	static const int64_t pow10[] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000 };
+	uint64_t u = v < 0 ? static_cast<uint64_t>(-v) : static_cast<uint64_t>(v);
+	if (v < 0)
+		*p++ = '-';
+	uint64_t whole = u / pow10[digits];
+	uint64_t frac = u % pow10[digits];
+	char tmp[24];
+	int n = 0;
+	do {
+		tmp[n++] = static_cast<char>('0' + whole % 10);
+		whole /= 10;
+	} while (whole != 0);
+	while (n > 0)
+		*p++ = tmp[--n];
+	if (digits > 0) {
+		*p++ = '.';
+		for (int i = static_cast<int>(digits) - 1; i >= 0; --i) {
+			p[i] = static_cast<char>('0' + frac % 10);
+			frac /= 10;
+		}
+		p += digits;
+	}
+	return p;
+}
+
+} // namespace
+
+GPSTrack::GPSTrack()
+	: arena(nullptr),
+	rows(0),
+	cap(0),
+	timeCol(nullptr),
+	latCol(nullptr),
+	lngCol(nullptr),
+	altCol(nullptr),
+	speedCol(nullptr),
+	courseCol(nullptr),
+	hdopCol(nullptr),
+	fieldsCol(nullptr),
+	satCol(nullptr),
+	lastDate(0),
+	lastDays(0)
+{}
+
+GPSTrack::~GPSTrack() {
+	free(arena);
+}
+
+void GPSTrack::clear() {
+	rows = 0;
+	lastDate = 0;
+	lastDays = 0;
+	epochs.reset();
+}
+
+void GPSTrack::allocate(size_t n) {
+	size_t offsets[9];
+	size_t total = 0;
+	const size_t widths[9] = {
+		sizeof(int64_t), sizeof(int32_t), sizeof(int32_t), sizeof(int32_t), sizeof(int32_t),
+		sizeof(int32_t), sizeof(uint16_t), sizeof(uint16_t), sizeof(uint8_t)
+	};
+	for (int i = 0; i < 9; ++i) {
+		offsets[i] = total;
+		total += alignUp(widths[i] * n);
+	}
+
+	unsigned char *raw = static_cast<unsigned char *>(malloc(total + kAlign));
+	if (raw == nullptr)
+		return;
+	unsigned char *next = raw + (alignUp(reinterpret_cast<uintptr_t>(raw)) - reinterpret_cast<uintptr_t>(raw));
+
+	// 既存の行を新しい領域へ列ごとにコピー
+	void *cols[9] = { timeCol, latCol, lngCol, altCol, speedCol, courseCol, hdopCol, fieldsCol, satCol };
+	for (int i = 0; i < 9; ++i) {
+		if (rows != 0)
+			memcpy(next + offsets[i], cols[i], widths[i] * rows);
+	}
+	free(arena);
+	arena = raw;
+	cap = n;
+	timeCol = reinterpret_cast<int64_t *>(next + offsets[0]);
+	latCol = reinterpret_cast<int32_t *>(next + offsets[1]);
+	lngCol = reinterpret_cast<int32_t *>(next + offsets[2]);
+	altCol = reinterpret_cast<int32_t *>(next + offsets[3]);
+	speedCol = reinterpret_cast<int32_t *>(next + offsets[4]);
+	courseCol = reinterpret_cast<int32_t *>(next + offsets[5]);
+	hdopCol = reinterpret_cast<uint16_t *>(next + offsets[6]);
+	fieldsCol = reinterpret_cast<uint16_t *>(next + offsets[7]);
+	satCol = reinterpret_cast<uint8_t *>(next + offsets[8]);
+}
+
+void GPSTrack::reserve(size_t n) {
+	if (n > cap)
+		allocate(n);
+}
+
+bool GPSTrack::append(const GPSFix &fix) {
+	if (!(fix.fields & GPSNMEA::Field_Location))
+		return false;
+	if (rows == cap) {
+		allocate(cap < 256 ? 256 : cap * 2);
+		if (rows == cap)
+			return false;  // 確保できなかった
+	}
+
+	if ((fix.fields & GPSNMEA::Field_Date) && fix.date != lastDate) {
+		lastDate = fix.date;
+		if (!gpsDateToDays(lastDate, lastDays))
+			lastDays = 0;
+	}
+	size_t i = rows++;
+	timeCol[i] = static_cast<int64_t>(lastDays) * 86400000 + gpsMillisOfDay(fix.time);
+	latCol[i] = fix.latE7;
+	lngCol[i] = fix.lngE7;
+	altCol[i] = fix.altitude;
+	speedCol[i] = fix.speed;
+	courseCol[i] = fix.course;
+	hdopCol[i] = fix.hdop;
+	fieldsCol[i] = fix.fields;
+	satCol[i] = fix.satellites;
+	return true;
+}
+
+//-----------------------------------
+// GPSNMEA からの取り込み
+//-----------------------------------
+void GPSTrack::onCommit(GPSNMEA &gps, uint16_t, void *context) {
+	GPSTrack *track = static_cast<GPSTrack *>(context);
+	if (track->epochs.add(gps)) {
+		GPSFix fix;
+		while (track->epochs.read(fix))
+			track->append(fix);
+	}
+}
+
+bool GPSTrack::attach(GPSNMEA &gps) {
+	return gps.onCommit(0xFFFF, onCommit, this);
+}
+
+void GPSTrack::detach(GPSNMEA &gps) {
+	gps.removeCommitCallback(onCommit, this);
+}
+
+void GPSTrack::flush() {
+	if (epochs.flush()) {
+		GPSFix fix;
+		while (epochs.read(fix))
+			append(fix);
+	}
+}
+
+//-----------------------------------
+// 書き出し
+//-----------------------------------
+bool GPSTrack::writeCSV(FILE *fp) const {
+	if (fputs("time_ms,lat,lng,altitude_m,speed_kn,course_deg,hdop,satellites\n", fp) < 0)
+		return false;
+	char line[160];
+	for (size_t i = 0; i < rows; ++i) {
+		char *p = putFixed(line, timeCol[i], 0);
+		*p++ = ',';
+		p = putFixed(p, latCol[i], 7);
+		*p++ = ',';
+		p = putFixed(p, lngCol[i], 7);
+		*p++ = ',';
+		p = putFixed(p, altCol[i], 2);
+		*p++ = ',';
+		p = putFixed(p, speedCol[i], 2);
+		*p++ = ',';
+		p = putFixed(p, courseCol[i], 2);
+		*p++ = ',';
+		p = putFixed(p, hdopCol[i], 2);
+		*p++ = ',';
+		p = putFixed(p, satCol[i], 0);
+		*p++ = '\n';
+		if (fwrite(line, 1, static_cast<size_t>(p - line), fp) != static_cast<size_t>(p - line))
+			return false;
+	}
+	return true;
+}
+
+bool GPSTrack::writeBinary(FILE *fp) const {
+	uint64_t count = rows;
+	bool ok = fwrite(kMagic, 1, sizeof(kMagic), fp) == sizeof(kMagic) &&
+		fwrite(&kVersion, sizeof(kVersion), 1, fp) == 1 &&
+		fwrite(&count, sizeof(count), 1, fp) == 1;
+	if (!ok || rows == 0)
+		return ok;
+	return fwrite(timeCol, sizeof(*timeCol), rows, fp) == rows &&
+		fwrite(latCol, sizeof(*latCol), rows, fp) == rows &&
+		fwrite(lngCol, sizeof(*lngCol), rows, fp) == rows &&
+		fwrite(altCol, sizeof(*altCol), rows, fp) == rows &&
+		fwrite(speedCol, sizeof(*speedCol), rows, fp) == rows &&
+		fwrite(courseCol, sizeof(*courseCol), rows, fp) == rows &&
+		fwrite(hdopCol, sizeof(*hdopCol), rows, fp) == rows &&
+		fwrite(fieldsCol, sizeof(*fieldsCol), rows, fp) == rows &&
+		fwrite(satCol, sizeof(*satCol), rows, fp) == rows;
+}
+
+bool GPSTrack::readBinary(FILE *fp) {
+	char magic[4];
+	uint32_t version;
+	uint64_t count;
+	if (fread(magic, 1, sizeof(magic), fp) != sizeof(magic) || memcmp(magic, kMagic, sizeof(magic)) != 0 ||
+		fread(&version, sizeof(version), 1, fp) != 1 || version != kVersion ||
+		fread(&count, sizeof(count), 1, fp) != 1)
+		return false;
+
+	clear();
+	size_t n = static_cast<size_t>(count);
+	reserve(n);
+	if (cap < n)
+		return false;
+	bool ok = n == 0 || (
+		fread(timeCol, sizeof(*timeCol), n, fp) == n &&
+		fread(latCol, sizeof(*latCol), n, fp) == n &&
+		fread(lngCol, sizeof(*lngCol), n, fp) == n &&
+		fread(altCol, sizeof(*altCol), n, fp) == n &&
+		fread(speedCol, sizeof(*speedCol), n, fp) == n &&
+		fread(courseCol, sizeof(*courseCol), n, fp) == n &&
+		fread(hdopCol, sizeof(*hdopCol), n, fp) == n &&
+		fread(fieldsCol, sizeof(*fieldsCol), n, fp) == n &&
+		fread(satCol, sizeof(*satCol), n, fp) == n);
+	rows = ok ? n : 0;
+	return ok;
+}
+
+#endif // GPSNMEA_HOST
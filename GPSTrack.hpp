@@ -0,0 +1,109 @@
+#ifndef GPS_TRACK_HPP
+#define GPS_TRACK_HPP
+
+#include "GPSNMEA.hpp"
+#include "GPSEpoch.hpp"
+
+#if GPSNMEA_HOST
+
+#include <stdio.h>
+
+// 連続領域のビュー (ポインタと長さのみ。所有しない)
+template <class T>
+struct GPSSpan {
+	const T *data;
+	size_t size;
+
+	const T *begin() const { return data; }
+	const T *end() const { return data + size; }
+	const T &operator[](size_t i) const { return data[i]; }
+	bool empty() const { return size == 0; }
+};
+
+//=================================================================
+// 列指向(Structure of Arrays)の軌跡 (ホストビルド専用)
+//  1エポック(GPSFix)を1行とし、項目ごとに連続した列に格納する。
+//  全ての列は1つの領域(アリーナ)に並べて確保し、容量が足りなければ倍に広げる。
+//  列は固定小数点の整数のまま保持するので、集計や書き出しで行ごとの double 変換が要らない
+//
+//  使い方:
+//    GPSTrack track;
+//    track.attach(gps);        // 以降 gps の commit ごとにエポック単位で追記される
+//    GPSSpan<int32_t> lat = track.latE7();
+//=================================================================
+class GPSTrack {
+public:
+	GPSTrack();
+	~GPSTrack();
+
+	void clear();
+	// rows 行分の容量を確保する (列の span は無効になる)
+	void reserve(size_t rows);
+
+	size_t size() const { return rows; }
+	size_t capacity() const { return cap; }
+
+	// 位置を含むエポックを1行追記する (位置の無いエポックは捨てて false)
+	//  日付の無いエポックは直前の日付を引き継ぐ
+	bool append(const GPSFix &fix);
+
+	// gps の commit コールバックに登録し、エポックが閉じるたびに追記する
+	bool attach(GPSNMEA &gps);
+	void detach(GPSNMEA &gps);
+	// 開いているエポックを閉じて追記する (ログの末尾など)
+	void flush();
+
+	// 列 (追記や reserve() で領域が移動すると無効になる)
+	GPSSpan<int64_t> time() const { return span(timeCol); }        // UTC ミリ秒 (gpsEpochMillis)
+	GPSSpan<int32_t> latE7() const { return span(latCol); }        // 度 x1e7
+	GPSSpan<int32_t> lngE7() const { return span(lngCol); }        // 度 x1e7
+	GPSSpan<int32_t> altitude() const { return span(altCol); }     // m x100
+	GPSSpan<int32_t> speed() const { return span(speedCol); }      // ノット x100
+	GPSSpan<int32_t> course() const { return span(courseCol); }    // 度 x100
+	GPSSpan<uint16_t> hdop() const { return span(hdopCol); }       // x100
+	GPSSpan<uint8_t> satellites() const { return span(satCol); }
+	GPSSpan<uint16_t> fields() const { return span(fieldsCol); }   // 行ごとの GPSNMEA::Field_xxx
+
+	// CSV (見出し行付き、固定小数点をそのまま10進で書く)
+	bool writeCSV(FILE *fp) const;
+	// 列ごとのバイナリ ("GTRK" 版数 行数 の後に各列をホストのバイト順で連続して書く)
+	bool writeBinary(FILE *fp) const;
+	bool readBinary(FILE *fp);
+
+private:
+	GPSTrack(const GPSTrack &);
+	GPSTrack &operator=(const GPSTrack &);
+
+	template <class T>
+	GPSSpan<T> span(const T *col) const {
+		GPSSpan<T> s = { col, rows };
+		return s;
+	}
+
+	// 容量 n の列を1つの領域に割り付ける
+	void allocate(size_t n);
+
+	static void onCommit(GPSNMEA &gps, uint16_t fields, void *context);
+
+	unsigned char *arena;   // 確保した領域 (列は64バイト境界から並ぶ)
+	size_t rows;
+	size_t cap;
+
+	int64_t *timeCol;
+	int32_t *latCol;
+	int32_t *lngCol;
+	int32_t *altCol;
+	int32_t *speedCol;
+	int32_t *courseCol;
+	uint16_t *hdopCol;
+	uint16_t *fieldsCol;
+	uint8_t *satCol;
+
+	uint32_t lastDate;
+	int32_t lastDays;  // lastDate の 1970-01-01 からの日数 (日付が変わった時だけ計算)
+	GPSEpochAssembler epochs;
+};
+
+#endif // GPSNMEA_HOST
+
+#endif // GPS_TRACK_HPP
@@ -0,0 +1,1039 @@
+// GPSNMEA ホストベンチマーク
+//
+//  bench/corpus/*.nmea を入力に encode / gpsParseDegrees / gpsParseDecimal /
+//  センテンス別のtermパース、バイナリfixログ、位置の読み出し、UTCエポック変換、
+//  距離・方位の計算、UBX-NAV-PVT のデコード、RTCM3 の切り出しと CRC-24Q、並列ログデコーダ、複数ストリームのエンジンのスループット(MB/s)と
+//  レイテンシ(ns/sentence, ns/op。x86 では cycles/op も)を計測する。
+//  結果は1行1件のJSON (JSON Lines) で標準出力へ書き出すので、
+//  リリース間の回帰比較にそのまま使える。
+//
+//  使い方:
+//    gpsnmea_bench [--corpus-dir DIR] [--min-time SEC] [--filter SUBSTR]
+#include "GPSByteRing.hpp"
+#include "GPSFixLog.hpp"
+#include "GPSGeodesy.hpp"
+#include "GPSNMEA.hpp"
+#include "GPSNMEAEngine.hpp"
+#include "GPSNMEALog.hpp"
+#include "GPSNMEAView.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#ifndef GPSNMEA_CORPUS_DIR
+#define GPSNMEA_CORPUS_DIR "bench/corpus"
+#endif
+
+// GPSNMEA の term単位のパース(スキーマ表の引き当て)へのアクセス口 (GPSNMEA.hpp で friend 指定)
+struct GPSNMEABenchAccess {
+	static void parseTerm(GPSNMEA &gps, GPSNMEA::SentenceType type, int termNumber, const std::string &term) {
+		gps.curSentenceType = type;
+		gps.curTermNumber = static_cast<uint8_t>(termNumber);
+		gps.handleTerm(term.c_str(), term.size());
+	}
+};
+
+namespace {
+
+// 最適化で計測対象が消されないための出口
+volatile uint64_t g_sink;
+// 結果の一致確認に失敗したら true (終了コードを 1 にする)
+bool g_checkFailed;
+
+struct Options {
+	std::string corpusDir = GPSNMEA_CORPUS_DIR;
+	double minTime = 0.2;
+	std::string filter;
+};
+
+struct Corpus {
+	std::string name;
+	std::string data;
+	size_t sentences = 0;
+	// センテンスごとの (アドレス, term列)。term[0] はアドレス
+	std::vector<std::vector<std::string>> split;
+};
+
+struct Result {
+	std::string bench;
+	std::string corpus;
+	uint64_t iterations;
+	double seconds;
+	uint64_t bytesPerIter;
+	uint64_t sentencesPerIter;
+	uint64_t opsPerIter;
+	uint64_t cycles = 0;  // 計測中のサイクル数 (readCycles() が使える環境のみ)
+};
+
+// サイクルカウンタ (x86 の TSC)。読めない環境では 0
+uint64_t readCycles() {
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return 0;
+#endif
+}
+
+bool loadFile(const std::string &path, std::string &out) {
+	std::ifstream in(path, std::ios::binary);
+	if (!in)
+		return false;
+	std::ostringstream ss;
+	ss << in.rdbuf();
+	out = ss.str();
+	return true;
+}
+
+void splitCorpus(Corpus &c) {
+	size_t pos = 0;
+	while ((pos = c.data.find('$', pos)) != std::string::npos) {
+		++c.sentences;
+		size_t end = c.data.find_first_of("*\r\n$", pos + 1);
+		if (end == std::string::npos)
+			end = c.data.size();
+		std::vector<std::string> terms;
+		std::string body = c.data.substr(pos + 1, end - pos - 1);
+		size_t start = 0;
+		for (;;) {
+			size_t comma = body.find(',', start);
+			terms.push_back(body.substr(start, comma == std::string::npos ? std::string::npos : comma - start));
+			if (comma == std::string::npos)
+				break;
+			start = comma + 1;
+		}
+		c.split.push_back(std::move(terms));
+		pos = end;
+	}
+}
+
+// 1回の処理 fn() を minTime 秒以上繰り返し、反復回数と経過時間を返す
+template <class F>
+void measure(const Options &opt, F fn, uint64_t &iterations, double &seconds) {
+	typedef std::chrono::steady_clock Clock;
+	fn();  // ウォームアップ
+	iterations = 0;
+	Clock::time_point start = Clock::now();
+	Clock::time_point now = start;
+	uint64_t batch = 1;
+	do {
+		for (uint64_t i = 0; i < batch; ++i)
+			fn();
+		iterations += batch;
+		batch *= 2;
+		now = Clock::now();
+	} while (std::chrono::duration<double>(now - start).count() < opt.minTime);
+	seconds = std::chrono::duration<double>(now - start).count();
+}
+
+void report(const Result &r) {
+	double totalBytes = static_cast<double>(r.bytesPerIter) * r.iterations;
+	double totalSentences = static_cast<double>(r.sentencesPerIter) * r.iterations;
+	double totalOps = static_cast<double>(r.opsPerIter) * r.iterations;
+	std::printf("{\"bench\":\"%s\",\"corpus\":\"%s\",\"iterations\":%llu,\"seconds\":%.6f",
+		r.bench.c_str(), r.corpus.c_str(), static_cast<unsigned long long>(r.iterations), r.seconds);
+	if (r.bytesPerIter)
+		std::printf(",\"bytes\":%llu,\"mb_per_s\":%.3f",
+			static_cast<unsigned long long>(r.bytesPerIter), totalBytes / r.seconds / 1e6);
+	if (r.sentencesPerIter)
+		std::printf(",\"sentences\":%llu,\"ns_per_sentence\":%.3f",
+			static_cast<unsigned long long>(r.sentencesPerIter), r.seconds * 1e9 / totalSentences);
+	if (r.opsPerIter)
+		std::printf(",\"ops\":%llu,\"ns_per_op\":%.3f",
+			static_cast<unsigned long long>(r.opsPerIter), r.seconds * 1e9 / totalOps);
+	if (r.opsPerIter && r.cycles)
+		std::printf(",\"cycles_per_op\":%.2f", r.cycles / totalOps);
+	std::printf("}\n");
+	std::fflush(stdout);
+}
+
+bool selected(const Options &opt, const std::string &name) {
+	return opt.filter.empty() || name.find(opt.filter) != std::string::npos;
+}
+
+std::string sentenceId(const std::vector<std::string> &terms) {
+	if (terms.empty() || terms[0].size() < 5)
+		return std::string();
+	return terms[0].substr(terms[0].size() - 3);
+}
+
+//-----------------------------------------------------------------
+// encode
+//-----------------------------------------------------------------
+void benchEncode(const Options &opt, const Corpus &c) {
+	if (selected(opt, "encode_byte")) {
+		Result r = { "encode_byte", c.name, 0, 0, c.data.size(), c.sentences, 0 };
+		measure(opt, [&]() {
+			GPSNMEA gps;
+			uint64_t n = 0;
+			for (char ch : c.data)
+				n += gps.encode(ch);
+			g_sink += n;
+		}, r.iterations, r.seconds);
+		report(r);
+	}
+	if (selected(opt, "encode_bulk")) {
+		Result r = { "encode_bulk", c.name, 0, 0, c.data.size(), c.sentences, 0 };
+		measure(opt, [&]() {
+			GPSNMEA gps;
+			g_sink += gps.encode(c.data.data(), c.data.size());
+		}, r.iterations, r.seconds);
+		report(r);
+	}
+	if (selected(opt, "encode_bulk_rmc_gga")) {
+		// RMC+GGAのみ購読 (他はチェックサム確認のみ)
+		Result r = { "encode_bulk_rmc_gga", c.name, 0, 0, c.data.size(), c.sentences, 0 };
+		measure(opt, [&]() {
+			GPSNMEA gps;
+			gps.subscribe(GPSNMEA_SENTENCE_RMC | GPSNMEA_SENTENCE_GGA);
+			g_sink += gps.encode(c.data.data(), c.data.size());
+		}, r.iterations, r.seconds);
+		report(r);
+	}
+	if (selected(opt, "encode_bulk_custom")) {
+		// 実在するセンテンスに GPSCustom を多数登録した場合
+		static const char *names[] = { "GPRMC", "GNRMC", "GPGGA", "GNGGA", "GPGSA", "GNGSA", "GPGSV", "GLGSV" };
+		Result r = { "encode_bulk_custom", c.name, 0, 0, c.data.size(), c.sentences, 0 };
+		measure(opt, [&]() {
+			GPSNMEA gps;
+			GPSCustom fields[8 * 6];
+			for (int i = 0; i < 8 * 6; ++i)
+				fields[i].begin(gps, names[i / 6], 1 + (i % 6) * 2);
+			g_sink += gps.encode(c.data.data(), c.data.size());
+		}, r.iterations, r.seconds);
+		report(r);
+	}
+#if GPSNMEA_INSTRUMENTATION
+	if (selected(opt, "parse_stats")) {
+		// 計測ビルド (-DGPSNMEA_INSTRUMENTATION=ON) のみ: 種別ごとの件数とパース時間の分布
+		GPSNMEA gps;
+		gps.encode(c.data.data(), c.data.size());
+		GPSNMEA::Stats stats;
+		gps.stats(stats);
+		// 1バイトのバッファで長さを求めてから書き出す (snprintf と同じく全体の長さが返る)
+		char probe[1];
+		std::string json(GPSNMEA::formatStats(stats, probe, sizeof(probe)) + 1, '\0');
+		GPSNMEA::formatStats(stats, &json[0], json.size());
+		std::printf("{\"bench\":\"parse_stats\",\"corpus\":\"%s\",\"stats\":%s}\n", c.name.c_str(), json.c_str());
+		std::fflush(stdout);
+	}
+#endif
+	if (selected(opt, "ring_drain")) {
+		// 受信側が64バイトずつ GPSByteRing へ書き、ループ側が drain() する場合
+		static GPSByteRing<1024> ring;
+		Result r = { "ring_drain", c.name, 0, 0, c.data.size(), c.sentences, 0 };
+		measure(opt, [&]() {
+			GPSNMEA gps;
+			uint64_t n = 0;
+			for (size_t off = 0; off < c.data.size(); off += 64) {
+				ring.push(c.data.data() + off, std::min<size_t>(64, c.data.size() - off));
+				n += ring.drain(gps);
+			}
+			g_sink += n;
+		}, r.iterations, r.seconds);
+		report(r);
+	}
+	if (selected(opt, "view_decode")) {
+		Result r = { "view_decode", c.name, 0, 0, c.data.size(), c.sentences, 0 };
+		measure(opt, [&]() {
+			GPSNMEA gps;
+			GPSSentenceReader reader(c.data.data(), c.data.size());
+			GPSSentenceView s;
+			uint64_t n = 0;
+			while (reader.next(s))
+				n += gps.decode(s);
+			g_sink += n;
+		}, r.iterations, r.seconds);
+		report(r);
+	}
+}
+
+//-----------------------------------------------------------------
+// 数値パーサ
+//-----------------------------------------------------------------
+void benchNumberParsers(const Options &opt, const Corpus &c) {
+	// 緯度経度と小数値のtermを集める
+	std::vector<std::string> degrees, decimals;
+	for (const std::vector<std::string> &t : c.split) {
+		std::string id = sentenceId(t);
+		if (id == "RMC" && t.size() > 8) {
+			degrees.push_back(t[3]); degrees.push_back(t[5]);
+			decimals.push_back(t[7]); decimals.push_back(t[8]);
+		} else if (id == "GGA" && t.size() > 9) {
+			degrees.push_back(t[2]); degrees.push_back(t[4]);
+			decimals.push_back(t[8]); decimals.push_back(t[9]);
+		}
+	}
+	if (!degrees.empty() && selected(opt, "parse_degrees")) {
+		Result r = { "parse_degrees", c.name, 0, 0, 0, 0, degrees.size() };
+		measure(opt, [&]() {
+			RawDegrees d;
+			uint64_t acc = 0;
+			for (const std::string &s : degrees) {
+				gpsParseDegrees(s.c_str(), d);
+				acc += d.billionths;
+			}
+			g_sink += acc;
+		}, r.iterations, r.seconds);
+		report(r);
+	}
+	if (!decimals.empty() && selected(opt, "parse_decimal")) {
+		Result r = { "parse_decimal", c.name, 0, 0, 0, 0, decimals.size() };
+		measure(opt, [&]() {
+			uint64_t acc = 0;
+			for (const std::string &s : decimals)
+				acc += static_cast<uint32_t>(gpsParseDecimal(s.c_str()));
+			g_sink += acc;
+		}, r.iterations, r.seconds);
+		report(r);
+	}
+	// 比較用: libc (atof/atol) で同じtermを読む場合
+	if (!decimals.empty() && selected(opt, "libc_atof")) {
+		Result r = { "libc_atof", c.name, 0, 0, 0, 0, decimals.size() };
+		measure(opt, [&]() {
+			double acc = 0;
+			for (const std::string &s : decimals)
+				acc += std::atof(s.c_str());
+			g_sink += static_cast<uint64_t>(acc);
+		}, r.iterations, r.seconds);
+		report(r);
+	}
+	if (!degrees.empty() && selected(opt, "parse_int")) {
+		Result r = { "parse_int", c.name, 0, 0, 0, 0, degrees.size() };
+		measure(opt, [&]() {
+			uint64_t acc = 0;
+			for (const std::string &s : degrees)
+				acc += static_cast<uint32_t>(gpsParseInt(s.c_str()));
+			g_sink += acc;
+		}, r.iterations, r.seconds);
+		report(r);
+	}
+	if (!degrees.empty() && selected(opt, "libc_atol")) {
+		Result r = { "libc_atol", c.name, 0, 0, 0, 0, degrees.size() };
+		measure(opt, [&]() {
+			uint64_t acc = 0;
+			for (const std::string &s : degrees)
+				acc += static_cast<uint64_t>(std::atol(s.c_str()));
+			g_sink += acc;
+		}, r.iterations, r.seconds);
+		report(r);
+	}
+}
+
+//-----------------------------------------------------------------
+// アドレスフィールド分類
+//-----------------------------------------------------------------
+void benchClassify(const Options &opt, const Corpus &c) {
+	if (!selected(opt, "classify_address"))
+		return;
+	std::vector<std::string> addresses;
+	for (const std::vector<std::string> &t : c.split)
+		addresses.push_back(t[0]);
+	Result r = { "classify_address", c.name, 0, 0, 0, 0, addresses.size() };
+	measure(opt, [&]() {
+		uint64_t acc = 0;
+		GPSNMEA::Talker talker;
+		for (const std::string &a : addresses)
+			acc += GPSNMEA::classifyAddress(a.data(), a.size(), talker) + talker;
+		g_sink += acc;
+	}, r.iterations, r.seconds);
+	report(r);
+}
+
+//-----------------------------------------------------------------
+// センテンス別のtermパース (スキーマ表の引き当て)
+//-----------------------------------------------------------------
+void benchTermParsers(const Options &opt, const Corpus &c) {
+	struct Target {
+		const char *id;
+		GPSNMEA::SentenceType type;
+	};
+	const Target targets[] = {
+		{ "RMC", GPSNMEA::SentenceType_RMC },
+		{ "GGA", GPSNMEA::SentenceType_GGA },
+		{ "GSA", GPSNMEA::SentenceType_GSA },
+		{ "GSV", GPSNMEA::SentenceType_GSV },
+		{ "VTG", GPSNMEA::SentenceType_VTG },
+		{ "GLL", GPSNMEA::SentenceType_GLL },
+	};
+	for (const Target &target : targets) {
+		std::string name = std::string("parse_") + target.id;
+		if (!selected(opt, name))
+			continue;
+		// endOfTermHandler と同じく空termは渡さない
+		std::vector<std::pair<int, std::string>> terms;
+		uint64_t sentences = 0;
+		for (const std::vector<std::string> &t : c.split) {
+			if (sentenceId(t) != target.id)
+				continue;
+			++sentences;
+			for (size_t i = 1; i < t.size(); ++i) {
+				if (!t[i].empty())
+					terms.push_back(std::make_pair(static_cast<int>(i), t[i]));
+			}
+		}
+		if (terms.empty())
+			continue;
+		Result r = { name, c.name, 0, 0, 0, sentences, terms.size() };
+		GPSNMEA gps;
+		measure(opt, [&]() {
+			for (const std::pair<int, std::string> &t : terms)
+				GPSNMEABenchAccess::parseTerm(gps, target.type, t.first, t.second);
+			g_sink += gps.gsv.satellitesInView;
+		}, r.iterations, r.seconds);
+		report(r);
+	}
+}
+
+//-----------------------------------------------------------------
+// 並列ログデコード (GPSNMEALogDecoder)
+//-----------------------------------------------------------------
+void benchLogDecode(const Options &opt, const std::vector<Corpus> &corpora) {
+	// 全コーパスを連結し、数MBになるまで繰り返したものを1本のログとする
+	std::string log;
+	size_t sentences = 0;
+	while (log.size() < (8u << 20)) {
+		for (const Corpus &c : corpora) {
+			log += c.data;
+			sentences += c.sentences;
+		}
+	}
+	unsigned hw = std::thread::hardware_concurrency();
+	std::vector<unsigned> counts = { 1 };
+	for (unsigned n = 2; n <= hw; n *= 2)
+		counts.push_back(n);
+	if (hw > 1 && counts.back() != hw)
+		counts.push_back(hw);
+	for (unsigned n : counts) {
+		std::string name = "log_decode_t" + std::to_string(n);
+		if (!selected(opt, name))
+			continue;
+		Result r = { name, "all", 0, 0, log.size(), sentences, 0 };
+		std::vector<GPSDecodedSentence> out;
+		measure(opt, [&]() {
+			GPSNMEALogDecoder decoder(n);
+			out.clear();
+			g_sink += decoder.decode(log.data(), log.size(), out);
+		}, r.iterations, r.seconds);
+		report(r);
+	}
+}
+
+//-----------------------------------------------------------------
+// バイナリfixログ (GPSFixLogWriter / GPSFixLogReader)
+//  bytes はバイナリログのサイズ、ops はレコード(エポック)数
+//-----------------------------------------------------------------
+bool appendLog(const uint8_t *data, size_t len, void *context) {
+	std::vector<uint8_t> *out = static_cast<std::vector<uint8_t> *>(context);
+	out->insert(out->end(), data, data + len);
+	return true;
+}
+
+void benchFixLog(const Options &opt, const Corpus &c) {
+	std::vector<GPSFix> fixes;
+	{
+		GPSNMEA gps;
+		GPSEpochAssembler epochs;
+		GPSFix fix;
+		GPSSentenceReader reader(c.data.data(), c.data.size());
+		GPSSentenceView s;
+		while (reader.next(s)) {
+			if (gps.decode(s) && epochs.add(gps))
+				while (epochs.read(fix))
+					fixes.push_back(fix);
+		}
+		epochs.flush();
+		while (epochs.read(fix))
+			fixes.push_back(fix);
+	}
+	std::vector<uint8_t> log;
+	{
+		GPSFixLogWriter writer(appendLog, &log);
+		for (const GPSFix &fix : fixes)
+			writer.write(fix);
+	}
+	if (fixes.empty())
+		return;
+
+	if (selected(opt, "fixlog_write")) {
+		Result r = { "fixlog_write", c.name, 0, 0, log.size(), 0, fixes.size() };
+		std::vector<uint8_t> out;
+		out.reserve(log.size());
+		measure(opt, [&]() {
+			out.clear();
+			GPSFixLogWriter writer(appendLog, &out);
+			for (const GPSFix &fix : fixes)
+				writer.write(fix);
+			writer.flush();
+			g_sink += out.size();
+		}, r.iterations, r.seconds);
+		report(r);
+	}
+	if (selected(opt, "fixlog_read")) {
+		Result r = { "fixlog_read", c.name, 0, 0, log.size(), 0, fixes.size() };
+		measure(opt, [&]() {
+			GPSFixLogReader reader(log.data(), log.size());
+			GPSFix fix;
+			uint64_t n = 0;
+			while (reader.next(fix))
+				n += fix.latE7;
+			g_sink += n;
+		}, r.iterations, r.seconds);
+		report(r);
+	}
+}
+
+//-----------------------------------------------------------------
+// 複数ストリームのエンジン (GPSNMEAEngine)
+//  256本の受信機が mixed コーパスを512バイトずつ交互に送ってくる想定で、
+//  ワーカー数ごとに全ストリームを処理し終えるまでを計測する
+//-----------------------------------------------------------------
+void benchEngine(const Options &opt, const std::vector<Corpus> &corpora) {
+	const Corpus &c = corpora[0];
+	const uint32_t streams = 256;
+	const size_t batch = 512;
+
+	unsigned hw = std::thread::hardware_concurrency();
+	std::vector<unsigned> counts = { 1 };
+	for (unsigned n = 2; n <= hw; n *= 2)
+		counts.push_back(n);
+	if (hw > 1 && counts.back() != hw)
+		counts.push_back(hw);
+	for (unsigned n : counts) {
+		std::string name = "engine_t" + std::to_string(n);
+		if (!selected(opt, name))
+			continue;
+		Result r = { name, "synthetic", 0, 0, c.data.size() * streams, c.sentences * streams, 0 };
+		GPSNMEAEngine engine(streams, n);
+		measure(opt, [&]() {
+			for (size_t off = 0; off < c.data.size(); off += batch) {
+				size_t len = std::min(batch, c.data.size() - off);
+				for (uint32_t s = 0; s < streams; ++s)
+					engine.submit(s, c.data.data() + off, len);
+			}
+			engine.wait();
+			g_sink += engine.sentencesDecoded(0);
+		}, r.iterations, r.seconds);
+		report(r);
+	}
+}
+
+//-----------------------------------------------------------------
+// fix ごとの位置の読み出し (double 版と 1e-7度整数版)
+//  位置・針路を表示用に取り出す処理を、コーパスの全fixについて行う
+//  FPUの無いMCUでは差がさらに大きい (ホストの値は下限の目安)
+//-----------------------------------------------------------------
+void benchLocation(const Options &opt, const Corpus &c) {
+	struct Fix {
+		GPSLocation location;
+		int32_t course;
+	};
+	std::vector<Fix> fixes;
+	{
+		GPSNMEA gps;
+		GPSSentenceReader reader(c.data.data(), c.data.size());
+		GPSSentenceView s;
+		while (reader.next(s)) {
+			if (gps.decode(s) && (gps.committedFields() & GPSNMEA::Field_Location)) {
+				Fix f = { gps.location, gps.course.value() };
+				fixes.push_back(f);
+			}
+		}
+	}
+	if (fixes.empty())
+		return;
+
+	double nsDouble = 0, cyclesDouble = 0;
+#if !GPSNMEA_NO_DOUBLE
+	if (selected(opt, "fix_location_double")) {
+		Result r = { "fix_location_double", c.name, 0, 0, 0, 0, fixes.size() };
+		uint64_t start = readCycles();
+		measure(opt, [&]() {
+			double sum = 0;
+			uintptr_t dir = 0;
+			for (Fix &f : fixes) {
+				sum += f.location.lat() + f.location.lng();
+				dir += reinterpret_cast<uintptr_t>(gpsCardinal(f.course / 100.0));
+			}
+			g_sink += static_cast<uint64_t>(sum) + dir;
+		}, r.iterations, r.seconds);
+		r.cycles = readCycles() - start;
+		report(r);
+		nsDouble = r.seconds * 1e9 / (static_cast<double>(r.iterations) * fixes.size());
+		cyclesDouble = r.cycles / (static_cast<double>(r.iterations) * fixes.size());
+	}
+#endif
+	if (selected(opt, "fix_location_e7")) {
+		Result r = { "fix_location_e7", c.name, 0, 0, 0, 0, fixes.size() };
+		uint64_t start = readCycles();
+		measure(opt, [&]() {
+			int64_t sum = 0;
+			uintptr_t dir = 0;
+			for (Fix &f : fixes) {
+				sum += static_cast<int64_t>(f.location.latE7()) + f.location.lngE7();
+				dir += reinterpret_cast<uintptr_t>(gpsCardinalX100(f.course));
+			}
+			g_sink += static_cast<uint64_t>(sum) + dir;
+		}, r.iterations, r.seconds);
+		r.cycles = readCycles() - start;
+		report(r);
+		if (nsDouble > 0) {
+			// double 版との差 (1fixあたり)
+			double ops = static_cast<double>(r.iterations) * fixes.size();
+			std::printf("{\"bench\":\"fix_location_saved\",\"corpus\":\"%s\",\"ns_per_fix\":%.3f",
+				c.name.c_str(), nsDouble - r.seconds * 1e9 / ops);
+			if (r.cycles)
+				std::printf(",\"cycles_per_fix\":%.2f", cyclesDouble - r.cycles / ops);
+			std::printf("}\n");
+			std::fflush(stdout);
+		}
+	}
+}
+
+//-----------------------------------------------------------------
+// UTC エポック変換 (1Hz の fix を数日分)
+//-----------------------------------------------------------------
+void benchEpoch(const Options &opt) {
+	const size_t n = 10000;
+	std::vector<uint32_t> dates(n), times(n);
+	uint32_t secs = 23 * 3600;
+	unsigned day = 30;
+	for (size_t i = 0; i < n; ++i, ++secs) {
+		if (secs == 86400) {
+			secs = 0;
+			++day;
+		}
+		dates[i] = (day % 31 + 1) * 10000 + 1225;  // ddmmyy
+		times[i] = ((secs / 3600) * 10000 + (secs / 60 % 60) * 100 + secs % 60) * 100;
+	}
+	if (selected(opt, "epoch_convert")) {
+		// fix ごとに暦計算をやり直す
+		Result r = { "epoch_convert", "synthetic", 0, 0, 0, 0, n };
+		measure(opt, [&]() {
+			int64_t sum = 0;
+			for (size_t i = 0; i < n; ++i)
+				sum += gpsEpochMillis(dates[i], times[i]);
+			g_sink += static_cast<uint64_t>(sum);
+		}, r.iterations, r.seconds);
+		report(r);
+	}
+	if (selected(opt, "epoch_cached")) {
+		// GPSDate と同じく、日付が変わった時だけ日数を求め直す
+		Result r = { "epoch_cached", "synthetic", 0, 0, 0, 0, n };
+		measure(opt, [&]() {
+			int64_t sum = 0;
+			uint32_t lastDate = 0;
+			int32_t days = 0;
+			for (size_t i = 0; i < n; ++i) {
+				if (dates[i] != lastDate) {
+					lastDate = dates[i];
+					gpsDateToDays(lastDate, days);
+				}
+				sum += static_cast<int64_t>(days) * 86400000 + gpsMillisOfDay(times[i]);
+			}
+			g_sink += static_cast<uint64_t>(sum);
+		}, r.iterations, r.seconds);
+		report(r);
+	}
+}
+
+//-----------------------------------------------------------------
+// 同じ fix を NMEA (RMC+GGA+GSA+VTG+GLL) と UBX-NAV-PVT で受け取った場合
+//-----------------------------------------------------------------
+void putLE(std::string &out, uint32_t v, int bytes) {
+	for (int i = 0; i < bytes; ++i)
+		out += static_cast<char>((v >> (8 * i)) & 0xFF);
+}
+
+void appendSentence(std::string &out, const char *body) {
+	char tail[8];
+	std::snprintf(tail, sizeof(tail), "*%02X\r\n", gpsXorBytes(body, std::strlen(body)));
+	out += '$';
+	out += body;
+	out += tail;
+}
+
+void benchUbx(const Options &opt) {
+	const size_t n = 1000;
+	std::string nmea, ubx;
+	for (size_t i = 0; i < n; ++i) {
+		const unsigned secs = static_cast<unsigned>(8 * 3600 + i);
+		const unsigned hh = secs / 3600, mm = secs / 60 % 60, ss = secs % 60;
+		const unsigned latMin = 725000 + static_cast<unsigned>(i * 7);  // 1e-6分単位。fix ごとに北へ
+		char body[128];
+		std::snprintf(body, sizeof(body), "GPRMC,%02u%02u%02u.00,A,4807.%04u,N,01131.0000,E,022.4,084.4,230394,003.1,W",
+			hh, mm, ss, latMin / 100);
+		appendSentence(nmea, body);
+		std::snprintf(body, sizeof(body), "GPGGA,%02u%02u%02u.00,4807.%04u,N,01131.0000,E,1,08,0.9,545.4,M,46.9,M,,",
+			hh, mm, ss, latMin / 100);
+		appendSentence(nmea, body);
+		appendSentence(nmea, "GPGSA,A,3,04,05,,09,12,,,24,,,,,2.5,1.3,2.1");
+		appendSentence(nmea, "GPVTG,084.4,T,,M,022.4,N,041.5,K,A");
+		std::snprintf(body, sizeof(body), "GPGLL,4807.%04u,N,01131.0000,E,%02u%02u%02u.00,A,A", latMin / 100, hh, mm, ss);
+		appendSentence(nmea, body);
+
+		std::string pvt;
+		putLE(pvt, static_cast<uint32_t>(secs * 1000), 4);
+		putLE(pvt, 1994, 2);
+		pvt += static_cast<char>(3);
+		pvt += static_cast<char>(23);
+		pvt += static_cast<char>(hh);
+		pvt += static_cast<char>(mm);
+		pvt += static_cast<char>(ss);
+		pvt += static_cast<char>(0x07);                                // validDate | validTime | fullyResolved
+		putLE(pvt, 30, 4);                                             // tAcc
+		putLE(pvt, 0, 4);                                              // nano
+		pvt += static_cast<char>(3);                                   // fixType
+		pvt += static_cast<char>(0x01);                                // gnssFixOK
+		pvt += static_cast<char>(0);
+		pvt += static_cast<char>(8);                                   // numSV
+		putLE(pvt, 115166667, 4);                                      // lon
+		putLE(pvt, 480000000 + (70000 + latMin / 100) * 1000 / 60, 4);  // lat (NMEA と同じ 48度07.xxxx分)
+		putLE(pvt, 592300, 4);                                         // height
+		putLE(pvt, 545400, 4);                                         // hMSL
+		putLE(pvt, 1200, 4);                                           // hAcc
+		putLE(pvt, 2000, 4);                                           // vAcc
+		putLE(pvt, 1100, 4);                                           // velN
+		putLE(pvt, 11470, 4);                                          // velE
+		putLE(pvt, 0, 4);                                              // velD
+		putLE(pvt, 11523, 4);                                          // gSpeed
+		putLE(pvt, 8440000, 4);                                        // headMot
+		putLE(pvt, 300, 4);                                            // sAcc
+		putLE(pvt, 50000, 4);                                          // headAcc
+		putLE(pvt, 250, 2);                                            // pDOP
+		pvt.append(14, '\0');                                          // flags3 .. magAcc
+
+		std::string frame;
+		frame += static_cast<char>(0x01);
+		frame += static_cast<char>(0x07);
+		putLE(frame, static_cast<uint32_t>(pvt.size()), 2);
+		frame += pvt;
+		uint8_t ckA = 0, ckB = 0;
+		gpsUbxChecksum(reinterpret_cast<const uint8_t *>(frame.data()), frame.size(), ckA, ckB);
+		ubx += static_cast<char>(0xB5);
+		ubx += static_cast<char>(0x62);
+		ubx += frame;
+		ubx += static_cast<char>(ckA);
+		ubx += static_cast<char>(ckB);
+	}
+
+	const std::pair<const char *, const std::string *> inputs[] = {
+		{ "fix_nmea_epoch", &nmea }, { "fix_ubx_navpvt", &ubx }
+	};
+	for (const auto &in : inputs) {
+		if (!selected(opt, in.first))
+			continue;
+		const std::string &data = *in.second;
+		GPSNMEA gps;
+		Result r = { in.first, "synthetic", 0, 0, data.size(), 0, n };
+		measure(opt, [&]() {
+			g_sink += gps.encode(data.data(), data.size());
+			g_sink += static_cast<uint64_t>(gps.location.latE7());
+		}, r.iterations, r.seconds);
+		report(r);
+	}
+}
+
+//-----------------------------------------------------------------
+// RTCM3 補正情報と NMEA が混ざったストリーム (RTK 基地局の1Hz出力を模す)
+//-----------------------------------------------------------------
+// 比較用: 表を使わないビット単位の CRC-24Q
+uint32_t crc24qBitwise(const uint8_t *p, size_t len) {
+	uint32_t r = 0;
+	while (len--) {
+		r ^= static_cast<uint32_t>(*p++) << 16;
+		for (int i = 0; i < 8; ++i) {
+			r <<= 1;
+			if (r & 0x1000000)
+				r ^= 0x1864CFB;
+		}
+	}
+	return r & 0xFFFFFF;
+}
+
+void benchRtcm(const Options &opt) {
+	// 1エポック: 1005 (基地局位置) と MSM7 4衛星系、1230 と、NMEA 3センテンス
+	const struct { uint16_t type; size_t length; } kFrames[] = {
+		{ 1005, 19 }, { 1077, 420 }, { 1087, 310 }, { 1097, 330 }, { 1127, 260 }, { 1230, 8 }
+	};
+	const size_t epochs = 200;
+	std::string stream;
+	std::vector<std::pair<size_t, size_t>> frames;  // stream 内の (位置, 長さ)
+	uint32_t seed = 2024;
+	size_t sentences = 0;
+	for (size_t e = 0; e < epochs; ++e) {
+		appendSentence(stream, "GNGGA,092750.00,5321.68020,N,00630.33720,W,4,12,0.65,61.7,M,55.2,M,1.0,0000");
+		appendSentence(stream, "GNRMC,092750.00,A,5321.68020,N,00630.33720,W,0.02,,161024,,,R,V");
+		appendSentence(stream, "GNGSA,A,3,05,13,15,18,20,23,24,29,,,,,1.12,0.65,0.91,1");
+		sentences += 3;
+		for (const auto &f : kFrames) {
+			std::string frame(3 + f.length, '\0');
+			frame[0] = static_cast<char>(0xD3);
+			frame[1] = static_cast<char>(f.length >> 8);
+			frame[2] = static_cast<char>(f.length & 0xFF);
+			for (size_t i = 3; i < frame.size(); ++i) {
+				seed = seed * 1664525u + 1013904223u;
+				frame[i] = static_cast<char>(seed >> 24);
+			}
+			frame[3] = static_cast<char>(f.type >> 4);
+			frame[4] = static_cast<char>(((f.type & 0xF) << 4) | (frame[4] & 0x0F));
+			uint32_t crc = gpsCrc24q(reinterpret_cast<const uint8_t *>(frame.data()), frame.size());
+			frame += static_cast<char>(crc >> 16);
+			frame += static_cast<char>(crc >> 8);
+			frame += static_cast<char>(crc);
+			frames.push_back(std::make_pair(stream.size(), frame.size()));
+			stream += frame;
+		}
+	}
+	const uint8_t *base = reinterpret_cast<const uint8_t *>(stream.data());
+	size_t frameBytes = 0;
+	for (const auto &f : frames)
+		frameBytes += f.second;
+
+	// encode(buf, len) と encode(char) の結果が、CRC の合わないフレームを含めて読み出し単位によらず一致するか
+	if (selected(opt, "rtcm_bulk_vs_byte")) {
+		// 1005 フレームのペイロードを NMEA らしいバイト列で上書きして CRC を壊す
+		//  (フレームを読み捨てずに NMEA として読み直すと、チェックサム違いが数えられてしまう)
+		std::string damaged = stream;
+		static const char kFake[] = "$GPTXT,01*00\r\n";
+		size_t badFrames = 0;
+		for (size_t i = 0; i < frames.size(); i += 200, ++badFrames)
+			damaged.replace(frames[i].first + 6, sizeof(kFake) - 1, kFake);
+		struct Counts {
+			uint32_t passed, failed, frames, badFrames;
+			int32_t latE7;
+			bool operator==(const Counts &o) const {
+				return passed == o.passed && failed == o.failed && frames == o.frames &&
+					badFrames == o.badFrames && latE7 == o.latE7;
+			}
+		};
+		// chunk = 0 なら1文字ずつ、SIZE_MAX なら一度に、それ以外は最大 chunk バイトの乱数長
+		auto run = [&](size_t chunk) {
+			GPSNMEA gps;
+			uint32_t split = 77;
+			for (size_t off = 0; off < damaged.size();) {
+				size_t n = damaged.size() - off;
+				if (chunk == 0) {
+					gps.encode(damaged[off]);
+					n = 1;
+				} else {
+					if (chunk != SIZE_MAX) {
+						split = split * 1664525u + 1013904223u;
+						n = std::min(n, 1 + (split >> 8) % chunk);
+					}
+					gps.encode(damaged.data() + off, n);
+				}
+				off += n;
+			}
+			Counts c = { gps.passedChecksumCount, gps.failedChecksumCount,
+				gps.rtcmFrameCount, gps.rtcmFailedCount, gps.location.latE7() };
+			return c;
+		};
+		const Counts byChar = run(0);
+		const size_t chunks[] = { SIZE_MAX, 512, 64, 7 };
+		bool match = byChar.badFrames == badFrames && byChar.frames == frames.size() - badFrames;
+		for (size_t chunk : chunks)
+			match = match && run(chunk) == byChar;
+		std::printf("{\"bench\":\"rtcm_bulk_vs_byte\",\"corpus\":\"synthetic\",\"match\":%s,"
+			"\"passed\":%lu,\"failed\":%lu,\"frames\":%lu,\"badFrames\":%lu}\n",
+			match ? "true" : "false", (unsigned long)byChar.passed, (unsigned long)byChar.failed,
+			(unsigned long)byChar.frames, (unsigned long)byChar.badFrames);
+		std::fflush(stdout);
+		if (!match) {
+			std::fprintf(stderr, "rtcm_bulk_vs_byte: encode(buf, len) and encode(char) disagree\n");
+			g_checkFailed = true;
+		}
+	}
+
+	// CRC のみ (表引き slice-by-N と、ビット単位の比較)
+	if (selected(opt, "rtcm_crc24")) {
+		Result r = { "rtcm_crc24", "synthetic", 0, 0, frameBytes, 0, frames.size() };
+		measure(opt, [&]() {
+			uint32_t sum = 0;
+			for (const auto &f : frames)
+				sum += gpsCrc24q(base + f.first, f.second - 3);
+			g_sink += sum;
+		}, r.iterations, r.seconds);
+		report(r);
+	}
+	if (selected(opt, "rtcm_crc24_bitwise")) {
+		Result r = { "rtcm_crc24_bitwise", "synthetic", 0, 0, frameBytes, 0, frames.size() };
+		measure(opt, [&]() {
+			uint32_t sum = 0;
+			for (const auto &f : frames)
+				sum += crc24qBitwise(base + f.first, f.second - 3);
+			g_sink += sum;
+		}, r.iterations, r.seconds);
+		report(r);
+	}
+
+	// encode() で NMEA をパースしながらフレームを切り出してコールバックへ (シリアルの読み出し単位を模して512バイトずつ)
+	uint64_t forwarded = 0;
+	auto forward = [](GPSNMEA &, const GPSRtcmFrame &frame, void *context) {
+		*static_cast<uint64_t *>(context) += frame.messageType;
+	};
+	const size_t batch = 512;
+	if (selected(opt, "rtcm_split")) {
+		GPSNMEA gps;
+		gps.onRtcm(forward, &forwarded);
+		Result r = { "rtcm_split", "synthetic", 0, 0, stream.size(), sentences, frames.size() };
+		measure(opt, [&]() {
+			for (size_t off = 0; off < stream.size(); off += batch)
+				g_sink += gps.encode(stream.data() + off, std::min(batch, stream.size() - off));
+		}, r.iterations, r.seconds);
+		report(r);
+	}
+
+	// 多数の基地局・移動局リンクをエンジンで並行に処理
+	const uint32_t links = 32;
+	std::string name = "rtcm_engine_links" + std::to_string(links);
+	if (selected(opt, name)) {
+		GPSNMEAEngine engine(links);
+		std::vector<uint64_t> perLink(links, 0);
+		for (uint32_t l = 0; l < links; ++l)
+			engine.decoder(l).onRtcm(forward, &perLink[l]);
+		Result r = { name, "synthetic", 0, 0, stream.size() * links, sentences * links, frames.size() * links };
+		measure(opt, [&]() {
+			for (size_t off = 0; off < stream.size(); off += batch) {
+				size_t len = std::min(batch, stream.size() - off);
+				for (uint32_t l = 0; l < links; ++l)
+					engine.submit(l, stream.data() + off, len);
+			}
+			engine.wait();
+		}, r.iterations, r.seconds);
+		report(r);
+		for (uint64_t v : perLink)
+			forwarded += v;
+	}
+	g_sink += forwarded;
+}
+
+//-----------------------------------------------------------------
+// 距離・方位 (点列の一括計算と、RawDegrees の1区間版)
+//  入力は決まった乱数列で作る1万点の軌跡 (1e-7度単位)
+//-----------------------------------------------------------------
+void benchGeodesy(const Options &opt) {
+	const size_t n = 10000;
+	std::vector<int32_t> lat(n), lng(n);
+	uint32_t seed = 12345;
+	int32_t la = 356813247, lo = 1397671908;
+	for (size_t i = 0; i < n; ++i) {
+		seed = seed * 1664525u + 1013904223u;
+		la += static_cast<int32_t>(seed >> 20) - 2048;
+		lo += static_cast<int32_t>((seed >> 8) & 0xFFF) - 2048;
+		lat[i] = la;
+		lng[i] = lo;
+	}
+	std::vector<double> out(n);
+
+	struct Kernel {
+		const char *name;
+		void (*fn)(const int32_t *, const int32_t *, size_t, double *);
+	};
+	static const Kernel kernels[] = {
+		{ "geo_haversine", gpsHaversineDistances },
+		{ "geo_equirectangular", gpsEquirectangularDistances },
+		{ "geo_bearing", gpsBearings },
+	};
+	for (const Kernel &k : kernels) {
+		if (!selected(opt, k.name))
+			continue;
+		Result r = { k.name, "synthetic", 0, 0, 0, 0, n - 1 };
+		measure(opt, [&]() {
+			k.fn(lat.data(), lng.data(), n, out.data());
+			g_sink += static_cast<uint64_t>(out[n / 2]);
+		}, r.iterations, r.seconds);
+		report(r);
+	}
+	if (selected(opt, "geo_cumulative")) {
+		Result r = { "geo_cumulative", "synthetic", 0, 0, 0, 0, n - 1 };
+		measure(opt, [&]() {
+			g_sink += static_cast<uint64_t>(gpsCumulativeDistances(lat.data(), lng.data(), n, out.data()));
+		}, r.iterations, r.seconds);
+		report(r);
+	}
+	if (selected(opt, "geo_distance_scalar")) {
+		// 比較用: 1区間ずつ libm で計算する場合
+		std::vector<RawDegrees> rlat(n), rlng(n);
+		for (size_t i = 0; i < n; ++i) {
+			int32_t v[2] = { lat[i], lng[i] };
+			RawDegrees *d[2] = { &rlat[i], &rlng[i] };
+			for (int j = 0; j < 2; ++j) {
+				uint32_t a = static_cast<uint32_t>(v[j] < 0 ? -v[j] : v[j]);
+				d[j]->deg = static_cast<uint8_t>(a / 10000000);
+				d[j]->billionths = (a % 10000000) * 100;
+				d[j]->negative = v[j] < 0;
+			}
+		}
+		Result r = { "geo_distance_scalar", "synthetic", 0, 0, 0, 0, n - 1 };
+		measure(opt, [&]() {
+			for (size_t i = 0; i + 1 < n; ++i)
+				out[i] = gpsDistanceBetween(rlat[i], rlng[i], rlat[i + 1], rlng[i + 1]);
+			g_sink += static_cast<uint64_t>(out[n / 2]);
+		}, r.iterations, r.seconds);
+		report(r);
+	}
+}
+
+void usage(const char *argv0) {
+	std::fprintf(stderr, "usage: %s [--corpus-dir DIR] [--min-time SEC] [--filter SUBSTR]\n", argv0);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+	Options opt;
+	for (int i = 1; i < argc; ++i) {
+		if (std::strcmp(argv[i], "--corpus-dir") == 0 && i + 1 < argc) {
+			opt.corpusDir = argv[++i];
+		} else if (std::strcmp(argv[i], "--min-time") == 0 && i + 1 < argc) {
+			opt.minTime = std::atof(argv[++i]);
+		} else if (std::strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+			opt.filter = argv[++i];
+		} else {
+			usage(argv[0]);
+			return 2;
+		}
+	}
+
+	const char *names[] = { "mixed", "gnss_multi", "corrupted" };
+	std::vector<Corpus> corpora;
+	for (const char *name : names) {
+		corpora.push_back(Corpus());
+		Corpus &c = corpora.back();
+		c.name = name;
+		std::string path = opt.corpusDir + "/" + name + ".nmea";
+		if (!loadFile(path, c.data)) {
+			std::fprintf(stderr, "cannot read corpus: %s\n", path.c_str());
+			return 1;
+		}
+		splitCorpus(c);
+
+		benchEncode(opt, c);
+		benchNumberParsers(opt, c);
+		benchClassify(opt, c);
+		benchTermParsers(opt, c);
+		benchFixLog(opt, c);
+		benchLocation(opt, c);
+	}
+	benchLogDecode(opt, corpora);
+	benchEngine(opt, corpora);
+	benchEpoch(opt);
+	benchUbx(opt);
+	benchRtcm(opt);
+	benchGeodesy(opt);
+	return g_checkFailed ? 1 : 0;
+}